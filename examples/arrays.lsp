@@ -0,0 +1,48 @@
+#!/usr/bin/env bali
+
+; Arrays are packed from lists of numbers. Integers make an integer array,
+; and any floating point number makes a floating point array.
+(setq 'a (make-array '(1 2 3 4 5 6 7 8 9 10)))
+(setq 'b (make-array '(0.5 1.5 2.5)))
+(write a)
+(write b)
+(write (array-length a))
+(write (array-ref a 3))
+(write (array-slice a 2 5))
+(write (array->list b))
+
+; Reductions over whole arrays.
+(write (array-sum a))
+(write (array-dot a a))
+(write (array-min b))
+(write (array-max a))
+
+; Element-wise arithmetic and comparisons of arrays of the same length.
+; Comparisons produce arrays of ones and zeroes.
+(setq 'c (make-array '(2.0 2.0 2.0)))
+(write (array+ a a))
+(write (array* b c))
+(write (array- b c))
+(write (array/ (make-array '(1 2 4)) (make-array '(2 2 2))))
+(write (array= a (array* (array/ a (array+ a a)) (array+ a a))))
+(write (array< b c))
+(write (array> a (make-array '(5 5 5 5 5 5 5 5 5 5))))
+
+; Expected output:
+; #s64(1 2 3 4 5 6 7 8 9 10)
+; #f64(0.5 1.5 2.5)
+; 10
+; 4
+; #s64(3 4 5)
+; (0.5 1.5 2.5)
+; 55
+; 385
+; 0.5
+; 10
+; #s64(2 4 6 8 10 12 14 16 18 20)
+; #f64(1.0 3.0 5.0)
+; #f64(-1.5 -0.5 0.5)
+; #f64(0.5 1.0 2.0)
+; #s64(1 1 1 1 1 1 1 1 1 1)
+; #s64(1 1 0)
+; #s64(0 0 0 0 0 1 1 1 1 1)
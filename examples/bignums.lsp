@@ -0,0 +1,31 @@
+#!/usr/bin/env bali
+
+; Integers have no size limit.
+(defun factorial (n)
+  (loop ((i n) (acc 1))
+    (if (= i 0) acc (recur (- i 1) (* acc i)))))
+
+(write (factorial 30))
+(setq 'two-to-128 340282366920938463463374607431768211456)
+(write (* two-to-128 (- two-to-128)))
+
+; Multiplication of large numbers splits them into halves, and division by
+; large numbers uses long division. Both are exact.
+(setq 'big (factorial 300))
+(setq 'square (* big big))
+(write (= (/ square big) big))
+(write (/ (* (factorial 60) 61) (factorial 59)))
+(write (- square (* big big)))
+
+; Results that fit into 64 bits become ordinary integers again.
+(write (/ (factorial 25) (factorial 23)))
+(write (- (+ 9223372036854775807 10) 10))
+
+; Expected output:
+; 265252859812191058636308480000000
+; -115792089237316195423570985008687907853269984665640564039457584007913129639936
+; true
+; 3660
+; 0
+; 600
+; 9223372036854775807
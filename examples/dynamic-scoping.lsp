@@ -0,0 +1,16 @@
+#!/usr/bin/env bali
+
+; Variables are scoped dynamically, so functions see the variables of the
+; functions that called them.
+(defun show-x () (write x))
+
+; Even when they are called in tail position.
+(defun with-parameter (x) (show-x))
+(with-parameter 5)
+
+(defun with-let () (let ((x 7)) (show-x)))
+(with-let)
+
+; Expected output:
+; 5
+; 7
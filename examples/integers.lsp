@@ -0,0 +1,33 @@
+#!/usr/bin/env bali
+
+; Arithmetic on integers is exact.
+(write (+ 9007199254740992 1))
+(write (* 123456789 987654321))
+
+; Division stays exact when there is no remainder, and produces floating
+; point numbers otherwise.
+(write (/ 100 4))
+(write (/ 7 2))
+
+; Results that don't fit into 64 bits are promoted instead of
+; overflowing.
+(write (+ 9223372036854775807 1))
+(write (- -9223372036854775808 1))
+(write (* 4294967296 4294967296))
+(write (/ -9223372036854775808 -1))
+
+; Integers and floating point numbers can be mixed.
+(write (+ 1 0.5))
+(write (= 3 3.0))
+
+; Expected output:
+; 9007199254740993
+; 121932631112635269
+; 25
+; 3.5
+; 9223372036854775808
+; -9223372036854775809
+; 18446744073709551616
+; 9223372036854775808
+; 1.5
+; true
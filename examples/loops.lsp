@@ -0,0 +1,34 @@
+#!/usr/bin/env bali
+
+; Sum numbers with `while` by updating a variable.
+(setq 'i 0)
+(setq 'total 0)
+(while (< i 5)
+  (setq 'total (+ total i))
+  (setq 'i (+ i 1)))
+(write total)
+
+; `dotimes` binds the counter to each integer from zero up to the count.
+(dotimes (j 4) (write j))
+
+; `loop` evaluates its body again with new values whenever `recur` is
+; called.
+(write (loop ((n 10) (acc 1)) (if (= n 0) acc (recur (- n 1) (* acc n)))))
+
+; `recur` and `return` belong to the enclosing loop or function even when
+; they are evaluated in arguments of a function call.
+(defun add-100 (a) (+ a 100))
+(write (loop ((n 0)) (if (< n 3) (add-100 (recur (+ n 1))) n)))
+
+(defun early () (+ 1 (add-100 (return 5))))
+(write (early))
+
+; Expected output:
+; 10
+; 0
+; 1
+; 2
+; 3
+; 3628800
+; 3
+; 5
@@ -0,0 +1,54 @@
+#!/usr/bin/env bali
+
+; Maps are created from keys followed by their values.
+(setq 'm (make-map 'one 1 'two 2))
+(write (get m 'one))
+(write (get m 'three))
+(write (map-size m))
+
+; Updates return new maps and leave the old ones as they were.
+(setq 'n (assoc m 'three 3))
+(write (map-size n))
+(write (get n 'three))
+(write (map-size (dissoc n 'one)))
+(write (map-size m))
+
+; Keys are compared by their structure, and numbers by their value
+; regardless of how they are written.
+(setq 'k (make-map '(1 2) 'pair 10 'ten))
+(write (get k (list 1 2)))
+(write (get k 10.0))
+(write (get (assoc k 10.0 'still-ten) 10))
+(write (map-size (assoc k 10.0 'still-ten)))
+
+; Integers that only round into the same floating point number are
+; different keys.
+(setq 'l (make-map 9007199254740993 'exact))
+(write (get l 9007199254740992.0))
+(write (get l 9007199254740993))
+
+; Large maps.
+(setq 'squares
+  (loop ((i 0) (result (make-map)))
+    (if (= i 1000) result (recur (+ i 1) (assoc result i (* i i))))))
+(write (map-size squares))
+(write (get squares 999))
+(write (length (keys squares)))
+
+; Expected output:
+; 1
+; nil
+; 2
+; 3
+; 3
+; 2
+; 2
+; pair
+; ten
+; still-ten
+; 2
+; nil
+; exact
+; 1000
+; 998001
+; 1000
@@ -0,0 +1,26 @@
+#!/usr/bin/env bali
+
+; `write` outputs a value followed by a new line.
+(write 'hello)
+(write "Hyvää päivää")
+(write '(nested (lists (of atoms)) and () empty ones))
+(write (lambda (x) (* x x)))
+(write (vector 1 (list 2 3) (make-map 'key 'value)))
+
+; Output is buffered, and `flush` writes out what has been collected so
+; far. Output is also flushed when the program exits.
+(flush)
+(dotimes (i 3) (write (* i 1.5)))
+(flush)
+(write 'done)
+
+; Expected output:
+; hello
+; Hyvää päivää
+; (nested (lists (of atoms)) and () empty ones)
+; (lambda (x) (* x x))
+; #(1 (2 3) {key value})
+; 0.0
+; 1.5
+; 3.0
+; done
@@ -0,0 +1,33 @@
+#!/usr/bin/env bali
+
+; Sequences compute their elements only when they are consumed.
+(write (sequence->list (range 5)))
+(write (sequence->list (range 2 10 3)))
+(write (sequence->list (seq '(a b c))))
+
+; `map`, `filter` and `take` over sequences return new sequences, without
+; computing any elements or building intermediate lists.
+(setq 'squares
+  (map (filter (range 1000000) (lambda (x) (> x 2))) (lambda (x) (* x x))))
+(write (sequence->list (take squares 5)))
+(write (sequence->list (take-while squares (lambda (x) (< x 100)))))
+
+; Range without end is infinite, so only a part of it can be consumed.
+(write (sequence->list (take (map (range) (lambda (x) (* x 7))) 4)))
+
+; `reduce` folds the elements into a single value, and `for-each` calls a
+; function with each of them.
+(write (reduce (range 1 101) + 0))
+(for-each (range 10 7 -1) (lambda (x) (write x)))
+
+; Expected output:
+; (0 1 2 3 4)
+; (2 5 8)
+; (a b c)
+; (9 16 25 36 49)
+; (9 16 25 36 49 64 81)
+; (0 7 14 21)
+; 5050
+; 10
+; 9
+; 8
@@ -0,0 +1,40 @@
+#!/usr/bin/env bali
+
+; Vectors have indexed access to their elements.
+(setq 'v (vector 'a 'b 'c))
+(write v)
+(write (vector-length v))
+(write (nth v 1))
+
+; Updates return new vectors and leave the old ones as they were.
+(setq 'w (set-nth v 1 'x))
+(write w)
+(write v)
+
+; Large vectors share most of their structure with the vectors they were
+; updated from.
+(defun numbers (n)
+  (loop ((i n) (result '()))
+    (if (= i 0) result (recur (- i 1) (cons (- i 1) result)))))
+
+(setq 'big (list->vector (numbers 1000)))
+(setq 'changed (set-nth big 500 'changed))
+(write (vector-length changed))
+(write (nth changed 500))
+(write (nth big 500))
+(write (nth changed 999))
+(write (subseq big 995 1000))
+(write (vector->list (subseq changed 498 503)))
+
+; Expected output:
+; #(a b c)
+; 3
+; b
+; #(a x c)
+; #(a b c)
+; 1000
+; changed
+; 500
+; 999
+; #(995 996 997 998 999)
+; (498 499 changed 501 502)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <bali/memory.hpp>
+
+namespace bali
+{
+  /**
+   * Immutable arbitrary precision integer, stored as sign and magnitude.
+   * Magnitude is a little endian sequence of 32-bit limbs without leading
+   * zeroes, so zero has no limbs at all.
+   */
+  class bignum final : public memory::counted
+  {
+  public:
+    using ptr = memory::ref<const bignum>;
+    using limb_type = std::uint32_t;
+    using container_type = std::vector<limb_type>;
+
+    static ptr make(std::int64_t value);
+
+    // Parses bignum from decimal digits, with optional sign.
+    static ptr parse(const std::u32string& text);
+
+    static ptr add(const bignum& a, const bignum& b);
+    static ptr subtract(const bignum& a, const bignum& b);
+    static ptr multiply(const bignum& a, const bignum& b);
+
+    // Truncating division. Divider must not be zero.
+    static void divide(
+      const bignum& a,
+      const bignum& b,
+      ptr& quotient,
+      ptr& remainder
+    );
+
+    // Returns negative number, zero or positive number depending on whether
+    // a is less than, equal to or greater than b.
+    static int compare(const bignum& a, const bignum& b);
+
+    inline bool is_negative() const
+    {
+      return m_negative;
+    }
+
+    inline bool is_zero() const
+    {
+      return m_limbs.empty();
+    }
+
+    ptr negate() const;
+
+    // Returns true and stores the value into the slot if it fits into 64
+    // bits.
+    bool to_integer(std::int64_t& slot) const;
+
+    double to_double() const;
+    std::u32string to_string() const;
+
+  private:
+    static ptr make(bool negative, container_type&& limbs);
+
+    explicit bignum(bool negative, container_type&& limbs);
+
+  private:
+    const bool m_negative;
+    const container_type m_limbs;
+  };
+}
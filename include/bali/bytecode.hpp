@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+
+#include <bali/scope.hpp>
+
+namespace bali::bytecode
+{
+  enum class opcode : std::uint32_t
+  {
+    // Operands: index of the constant.
+    push_constant,
+    push_nil,
+    pop,
+    // Operands: depth and index of the slot.
+    load_local,
+    // Operands: index of the constant that is evaluated with the tree
+    // walking evaluator.
+    eval,
+    // Operands: symbol identifier of the variable.
+    set_dynamic,
+    // Operands: target of the jump.
+    jump,
+    jump_if_false,
+    jump_if_true,
+    not_,
+    // Numbers used in arithmetic and comparisons are kept unboxed in a
+    // separate stack, and are boxed into atoms only when their values are
+    // needed.
+    // Operands: index of the number.
+    push_number,
+    pop_number,
+    // Operands: index of the call form and index of the operand in it,
+    // used for reporting errors.
+    unbox,
+    box,
+    // Operands: number of arguments.
+    add,
+    subtract,
+    multiply,
+    divide,
+    // Operands: target of the jump taken when the comparison fails.
+    eq,
+    lt,
+    gt,
+    lte,
+    gte,
+    // Operands: index of the call form and number of instructions to skip
+    // after calling a builtin function.
+    call_builtin,
+    // Operands: number of arguments.
+    call,
+    tail_call,
+    // Operands: index of the layout of the new scope.
+    enter_scope,
+    leave_scope,
+    // Operands: index of the layout of the current scope, whose variables
+    // are replaced with values from the stack.
+    rebind,
+    // Operands: target of the jump taken once the counter, which is in top
+    // of the number stack, has reached the count below it, and symbol
+    // identifier of the variable where the counter is stored.
+    iterate,
+  };
+
+  // Custom function called in tail position, which is left for the caller
+  // of the program to call.
+  struct tail_call
+  {
+    memory::ref<value::function::custom> function;
+    value::list::container_type arguments;
+    // Scope where the function was called from.
+    memory::ref<class scope> scope;
+  };
+
+  class program
+  {
+  public:
+    using code_type = std::vector<std::uint32_t>;
+    using constant_container_type = std::vector<value::ptr>;
+    using number_container_type = std::vector<number>;
+    using layout_type = std::vector<symbol::id>;
+    using layout_container_type = std::vector<layout_type>;
+
+    explicit program(const value::ptr& expression);
+    program(const program&) = delete;
+    program(program&&) = delete;
+    void operator=(const program&) = delete;
+    void operator=(program&&) = delete;
+
+    inline const code_type& code() const
+    {
+      return m_code;
+    }
+
+    inline const constant_container_type& constants() const
+    {
+      return m_constants;
+    }
+
+    inline const number_container_type& numbers() const
+    {
+      return m_numbers;
+    }
+
+    inline const layout_container_type& layouts() const
+    {
+      return m_layouts;
+    }
+
+    value::ptr execute(
+      const memory::ref<class scope>& scope,
+      tail_call* tail = nullptr
+    ) const;
+
+  private:
+    code_type m_code;
+    constant_container_type m_constants;
+    number_container_type m_numbers;
+    layout_container_type m_layouts;
+
+    friend class compiler;
+  };
+
+  // Whether bodies of custom functions should be compiled into bytecode
+  // instead of being evaluated by the tree walking evaluator.
+  extern bool enabled;
+}
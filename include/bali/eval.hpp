@@ -6,36 +6,85 @@ namespace bali
 {
   value::ptr eval(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   );
 
-  const std::u32string&
+  // Once `return` has been evaluated, nothing else is evaluated until the
+  // evaluation has unwound back to the custom function that is returning,
+  // which then takes the return value.
+  bool is_returning();
+  void begin_return(const value::ptr& value);
+  value::ptr end_return();
+
+  // `recur` unwinds the evaluation like `return` does, but it is taken by
+  // the innermost `loop` instead, which rebinds its variables with the
+  // values and starts over.
+  bool is_recurring();
+  void begin_recur(value::list::container_type&& values);
+  value::list::container_type end_recur();
+
+  // Discards pending `return` or `recur` without taking its value, for
+  // recovering from errors.
+  void reset_return();
+
+  std::u32string
   to_atom(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
+  );
+
+  symbol::id
+  to_symbol(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
   );
 
   bool
   to_bool(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   );
 
-  std::shared_ptr<value::function>
+  memory::ref<value::function>
   to_function(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   );
 
-  const value::list::container_type&
+  memory::ref<value::list>
   to_list(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
+  );
+
+  memory::ref<value::array>
+  to_array(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  );
+
+  memory::ref<value::vector>
+  to_vector(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  );
+
+  memory::ref<value::map>
+  to_map(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  );
+
+  // Lists and vectors are converted into sequences of their elements.
+  memory::ref<value::sequence>
+  to_sequence(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
   );
 
-  double
+  number
   to_number(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   );
 }
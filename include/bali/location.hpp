@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+namespace bali::location
+{
+  // Source locations of parsed values are stored in a table shared by all
+  // parsed files, so that values only need to carry an identifier of
+  // their location. Values created at runtime have no location.
+  //
+  // Entries are reference counted by the values that carry them, so that
+  // locations of source code that is no longer alive can be reused.
+  enum class id : std::uint32_t
+  {
+    none,
+  };
+
+  // Returns new entry with a single reference.
+  id make(const std::optional<int>& line, const std::optional<int>& column);
+  id retain(id location);
+  void release(id location);
+  std::optional<int> line(id location);
+  std::optional<int> column(id location);
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace bali::memory
+{
+  // Allocates memory from pool of blocks of the same size class. Freed
+  // blocks are kept for reuse instead of being returned to the system.
+  // Sizes too large for any of the size classes are allocated directly.
+  void* allocate(std::size_t size);
+  void deallocate(void* pointer, std::size_t size);
+
+  /**
+   * Base class for objects that are managed by references. Objects are
+   * allocated from the pools and carry their own reference count, which is
+   * not atomic, as the interpreter is single threaded.
+   */
+  class counted
+  {
+  public:
+    counted() = default;
+
+    // Copies are new objects with their own references.
+    counted(const counted&) {}
+
+    virtual ~counted() = default;
+
+    counted& operator=(const counted&)
+    {
+      return *this;
+    }
+
+    static inline void* operator new(std::size_t size)
+    {
+      return allocate(size);
+    }
+
+    static inline void operator delete(void* pointer, std::size_t size)
+    {
+      deallocate(pointer, size);
+    }
+
+    inline void retain() const
+    {
+      ++m_references;
+    }
+
+    inline void release() const
+    {
+      if (!--m_references)
+      {
+        delete this;
+      }
+    }
+
+  private:
+    mutable std::uint32_t m_references = 0;
+  };
+
+  /**
+   * Reference to an object derived from counted, with interface similar to
+   * std::shared_ptr.
+   */
+  template<class T>
+  class ref
+  {
+  public:
+    using element_type = T;
+
+    ref(std::nullptr_t = nullptr)
+      : m_pointer(nullptr) {}
+
+    explicit ref(T* pointer)
+      : m_pointer(pointer)
+    {
+      retain();
+    }
+
+    ref(const ref& that)
+      : m_pointer(that.m_pointer)
+    {
+      retain();
+    }
+
+    ref(ref&& that)
+      : m_pointer(that.m_pointer)
+    {
+      that.m_pointer = nullptr;
+    }
+
+    template<
+      class U,
+      class = std::enable_if_t<std::is_convertible_v<U*, T*>>
+    >
+    ref(const ref<U>& that)
+      : m_pointer(that.m_pointer)
+    {
+      retain();
+    }
+
+    template<
+      class U,
+      class = std::enable_if_t<std::is_convertible_v<U*, T*>>
+    >
+    ref(ref<U>&& that)
+      : m_pointer(that.m_pointer)
+    {
+      that.m_pointer = nullptr;
+    }
+
+    ~ref()
+    {
+      if (m_pointer)
+      {
+        m_pointer->release();
+      }
+    }
+
+    ref& operator=(const ref& that)
+    {
+      ref(that).swap(*this);
+
+      return *this;
+    }
+
+    ref& operator=(ref&& that)
+    {
+      ref(std::move(that)).swap(*this);
+
+      return *this;
+    }
+
+    inline T* get() const
+    {
+      return m_pointer;
+    }
+
+    inline T& operator*() const
+    {
+      return *m_pointer;
+    }
+
+    inline T* operator->() const
+    {
+      return m_pointer;
+    }
+
+    inline explicit operator bool() const
+    {
+      return m_pointer != nullptr;
+    }
+
+    inline void reset()
+    {
+      ref().swap(*this);
+    }
+
+    // Gives up the reference without releasing the object, leaving the
+    // caller responsible for releasing it.
+    inline T* detach()
+    {
+      const auto pointer = m_pointer;
+
+      m_pointer = nullptr;
+
+      return pointer;
+    }
+
+    inline void swap(ref& that)
+    {
+      std::swap(m_pointer, that.m_pointer);
+    }
+
+  private:
+    inline void retain() const
+    {
+      if (m_pointer)
+      {
+        m_pointer->retain();
+      }
+    }
+
+  private:
+    T* m_pointer;
+
+    template<class> friend class ref;
+  };
+
+  template<class T, class U>
+  inline bool operator==(const ref<T>& a, const ref<U>& b)
+  {
+    return a.get() == b.get();
+  }
+
+  template<class T, class U>
+  inline bool operator!=(const ref<T>& a, const ref<U>& b)
+  {
+    return a.get() != b.get();
+  }
+
+  template<class T>
+  inline bool operator==(const ref<T>& a, std::nullptr_t)
+  {
+    return !a;
+  }
+
+  template<class T>
+  inline bool operator!=(const ref<T>& a, std::nullptr_t)
+  {
+    return static_cast<bool>(a);
+  }
+
+  template<class T>
+  inline bool operator==(std::nullptr_t, const ref<T>& a)
+  {
+    return !a;
+  }
+
+  template<class T>
+  inline bool operator!=(std::nullptr_t, const ref<T>& a)
+  {
+    return static_cast<bool>(a);
+  }
+
+  template<class T, class U>
+  inline ref<T> static_pointer_cast(const ref<U>& that)
+  {
+    return ref<T>(static_cast<T*>(that.get()));
+  }
+
+  template<class T, class U>
+  inline ref<T> dynamic_pointer_cast(const ref<U>& that)
+  {
+    return ref<T>(dynamic_cast<T*>(that.get()));
+  }
+
+  template<class T, class... Args>
+  inline ref<T> make(Args&&... args)
+  {
+    return ref<T>(new T(std::forward<Args>(args)...));
+  }
+}
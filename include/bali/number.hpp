@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <bali/bignum.hpp>
+
+namespace bali
+{
+  /**
+   * Numbers are exact integers of arbitrary size, or floating point numbers.
+   * Integers that fit into 64 bits are stored directly and larger ones are
+   * promoted into bignums. Division that leaves a remainder produces
+   * floating point number.
+   */
+  class number
+  {
+  public:
+    using integer_type = std::int64_t;
+    using real_type = double;
+
+    number(int value = 0)
+      : m_kind(kind::integer)
+      , m_integer(value) {}
+
+    number(integer_type value)
+      : m_kind(kind::integer)
+      , m_integer(value) {}
+
+    number(real_type value)
+      : m_kind(kind::real)
+      , m_real(value) {}
+
+    // Bignums that fit into 64 bits are stored as integers.
+    number(const bignum::ptr& value);
+
+    // Parses number from text that has been validated with
+    // utils::is_number().
+    static number parse(const std::u32string& text);
+
+    // Returns true if the number is an integer that fits into 64 bits.
+    inline bool is_integer() const
+    {
+      return m_kind == kind::integer;
+    }
+
+    inline bool is_bignum() const
+    {
+      return m_kind == kind::bignum;
+    }
+
+    inline bool is_exact() const
+    {
+      return m_kind != kind::real;
+    }
+
+    inline integer_type integer() const
+    {
+      return m_integer;
+    }
+
+    // Returns the number as floating point number, regardless of whether
+    // it's an integer or not.
+    inline real_type real() const
+    {
+      if (m_kind == kind::integer)
+      {
+        return static_cast<real_type>(m_integer);
+      }
+      else if (m_kind == kind::bignum)
+      {
+        return m_bignum->to_double();
+      }
+
+      return m_real;
+    }
+
+    // Returns exact number as bignum, regardless of whether it fits into 64
+    // bits or not.
+    bignum::ptr to_bignum() const;
+
+    inline bool is_zero() const
+    {
+      // Bignums are never zero, as zero fits into 64 bits.
+      if (m_kind == kind::integer)
+      {
+        return m_integer == 0;
+      }
+      else if (m_kind == kind::bignum)
+      {
+        return false;
+      }
+
+      return m_real == 0;
+    }
+
+    number operator-() const;
+    number& operator+=(const number& that);
+    number& operator-=(const number& that);
+    number& operator*=(const number& that);
+    // Divider must not be zero.
+    number& operator/=(const number& that);
+
+    std::u32string to_string() const;
+
+  private:
+    enum class kind
+    {
+      integer,
+      real,
+      bignum
+    };
+
+    kind m_kind;
+    union
+    {
+      integer_type m_integer;
+      real_type m_real;
+    };
+    bignum::ptr m_bignum;
+  };
+
+  bool operator==(const number& a, const number& b);
+  bool operator<(const number& a, const number& b);
+
+  inline bool operator!=(const number& a, const number& b)
+  {
+    return !(a == b);
+  }
+
+  inline bool operator>(const number& a, const number& b)
+  {
+    return b < a;
+  }
+
+  inline bool operator<=(const number& a, const number& b)
+  {
+    return !(b < a);
+  }
+
+  inline bool operator>=(const number& a, const number& b)
+  {
+    return !(a < b);
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace bali
+{
+  /**
+   * Output port that collects written text into a large buffer, which is
+   * written into the file only once the buffer fills up, when the port is
+   * flushed or when the program exits. Ports connected to a terminal are
+   * flushed after each line instead, so that interactive output shows up
+   * right away.
+   */
+  class port final : public std::streambuf
+  {
+  public:
+    // Port connected to the standard output.
+    static port& standard();
+
+    // Port where `write` writes into. This is the standard output unless
+    // it has been redirected into a file.
+    static port& current();
+
+    // Redirects `write` into given file, which is truncated. Returns false
+    // if the file cannot be opened.
+    static bool redirect(const std::string& filename);
+
+    explicit port(std::FILE* file, bool owned = false);
+    ~port();
+    port(const port&) = delete;
+    port(port&&) = delete;
+    void operator=(const port&) = delete;
+    void operator=(port&&) = delete;
+
+    inline std::ostream& stream()
+    {
+      return m_stream;
+    }
+
+    inline bool is_line_buffered() const
+    {
+      return m_line_buffered;
+    }
+
+    // Terminates current line, and flushes the port if it's line buffered.
+    void end_line();
+
+    void flush();
+
+  protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+  private:
+    bool drain();
+
+  private:
+    std::FILE* m_file;
+    const bool m_owned;
+    const bool m_line_buffered;
+    std::vector<char> m_buffer;
+    std::ostream m_stream;
+  };
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <streambuf>
+
+#include <bali/value.hpp>
+
+namespace bali
+{
+  /**
+   * Writes textual representation of the value into the buffer, encoded as
+   * UTF-8. Nested values are walked with an explicit stack instead of
+   * recursion, so how deeply values can be nested is not limited by the
+   * size of the native stack.
+   */
+  void print(std::streambuf& output, const value::ptr& value);
+}
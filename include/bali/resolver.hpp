@@ -0,0 +1,12 @@
+#pragma once
+
+#include <bali/value.hpp>
+
+namespace bali
+{
+  value::ptr
+  resolve(
+    const std::vector<symbol::id>& parameters,
+    const value::ptr& expression
+  );
+}
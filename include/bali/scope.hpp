@@ -6,25 +6,57 @@
 
 namespace bali
 {
-  class scope
+  /**
+   * Top level scope stores its variables in an hash table, while nested
+   * scopes (function calls and `let` forms) are flat arrays of slots, which
+   * can be addressed directly with lexical addresses computed by the
+   * resolver.
+   */
+  class scope : public memory::counted
   {
   public:
-    using container_type = std::unordered_map<std::u32string, value::ptr>;
+    using container_type = std::unordered_map<symbol::id, value::ptr>;
+    using slot_type = std::pair<symbol::id, value::ptr>;
+    using slot_container_type = std::vector<slot_type>;
+    using size_type = slot_container_type::size_type;
 
-    static std::shared_ptr<scope> make_top_level();
+    static memory::ref<scope> make_top_level();
 
-    explicit scope(const std::shared_ptr<scope>& parent = nullptr);
+    explicit scope(
+      const memory::ref<scope>& parent = nullptr,
+      size_type size = 0
+    );
     scope(const scope&) = default;
     scope(scope&&) = default;
     scope& operator=(const scope&) = default;
     scope& operator=(scope&&) = default;
 
-    bool get(const std::u32string& name, value::ptr& slot) const;
-    void let(const std::u32string& name, const value::ptr& value);
-    void set(const std::u32string& name, const value::ptr& value);
+    inline const memory::ref<scope>& parent() const
+    {
+      return m_parent;
+    }
+
+    bool get(symbol::id name, value::ptr& slot) const;
+    void let(symbol::id name, const value::ptr& value);
+    void set(symbol::id name, const value::ptr& value);
+
+    const value::ptr& at(
+      const value::atom::lexical_address& address
+    ) const;
+
+    // Removes scopes between this scope and given ancestor whose variables
+    // are all shadowed by scopes closer to this one, as nothing can see them
+    // through this scope anymore. Scopes up to the ancestor must not be in
+    // use elsewhere, as lexical addresses relative to them would change.
+    void drop_shadowed(const memory::ref<scope>& ancestor);
+
+  private:
+    value::ptr* find(symbol::id name);
+    const value::ptr* find(symbol::id name) const;
 
   private:
-    std::shared_ptr<scope> m_parent;
+    memory::ref<scope> m_parent;
     container_type m_variables;
+    slot_container_type m_slots;
   };
 }
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Kernels for packed numeric arrays. They are vectorized with AVX2 or SSE2,
+ * depending on what the compiler targets, and fall back to scalar code
+ * elsewhere or when BALI_NO_SIMD is defined.
+ */
+namespace bali::simd
+{
+  using integer_type = std::int64_t;
+  using real_type = double;
+  using size_type = std::size_t;
+
+  enum class operation
+  {
+    add,
+    subtract,
+    multiply,
+    divide,
+  };
+
+  enum class comparison
+  {
+    equal,
+    less,
+    greater,
+  };
+
+  // Order of additions in the reductions of floating point numbers differs
+  // from summing them sequentially, so the results may differ in the last
+  // bits.
+  real_type sum(const real_type* data, size_type size);
+  real_type dot(const real_type* a, const real_type* b, size_type size);
+  real_type min(const real_type* data, size_type size);
+  real_type max(const real_type* data, size_type size);
+
+  // Integer kernels return false if the result does not fit into 64 bits.
+  bool sum(const integer_type* data, size_type size, integer_type& result);
+  bool dot(
+    const integer_type* a,
+    const integer_type* b,
+    size_type size,
+    integer_type& result
+  );
+  integer_type min(const integer_type* data, size_type size);
+  integer_type max(const integer_type* data, size_type size);
+
+  void apply(
+    operation op,
+    const real_type* a,
+    const real_type* b,
+    real_type* result,
+    size_type size
+  );
+
+  // Returns false if any of the results does not fit into 64 bits, or if
+  // division leaves a remainder. Divider must not contain zeroes.
+  bool apply(
+    operation op,
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  );
+
+  // Results of the comparisons are stored as ones and zeroes.
+  void compare(
+    comparison op,
+    const real_type* a,
+    const real_type* b,
+    integer_type* result,
+    size_type size
+  );
+  void compare(
+    comparison op,
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  );
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace bali::symbol
+{
+  using id = std::uint32_t;
+
+  // Symbols that have fixed identifiers. These are interned before anything
+  // else, in the order they are listed here.
+  enum : id
+  {
+    nil,
+    true_,
+    quote,
+    let,
+    lambda,
+    defun,
+    dotimes,
+    loop,
+  };
+
+  id intern(const std::u32string& name);
+  const std::u32string& name(id symbol);
+}
@@ -1,8 +1,40 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <string>
 
 namespace bali::utils
 {
   bool is_number(const std::u32string& input);
+
+  inline bool add_overflows(std::int64_t a, std::int64_t b)
+  {
+    using limits = std::numeric_limits<std::int64_t>;
+
+    return b > 0 ? a > limits::max() - b : a < limits::min() - b;
+  }
+
+  inline bool subtract_overflows(std::int64_t a, std::int64_t b)
+  {
+    using limits = std::numeric_limits<std::int64_t>;
+
+    return b < 0 ? a > limits::max() + b : a < limits::min() + b;
+  }
+
+  inline bool multiply_overflows(std::int64_t a, std::int64_t b)
+  {
+    using limits = std::numeric_limits<std::int64_t>;
+
+    if (a > 0)
+    {
+      return b > 0 ? a > limits::max() / b : b < limits::min() / a;
+    }
+    else if (b > 0)
+    {
+      return a < limits::min() / b;
+    }
+
+    return a != 0 && b < limits::max() / a;
+  }
 }
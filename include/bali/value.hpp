@@ -1,38 +1,60 @@
 #pragma once
 
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include <bali/location.hpp>
+#include <bali/memory.hpp>
+#include <bali/number.hpp>
+#include <bali/symbol.hpp>
+
 namespace bali
 {
-  class value
+  namespace bytecode
+  {
+    class program;
+  }
+
+  class value : public memory::counted
   {
   public:
-    using ptr = std::shared_ptr<value>;
+    class ptr;
 
     enum class type
     {
       atom,
       function,
       list,
+      array,
+      vector,
+      map,
+      sequence,
     };
 
     class atom;
     class function;
     class list;
+    class array;
+    class vector;
+    class map;
+    class sequence;
 
-    static inline std::u32string to_string(const ptr& value)
-    {
-      return value ? value->to_string() : U"nil";
-    }
+    // Returns textual representation of the value, as written by the
+    // printer.
+    static std::u32string to_string(const ptr& value);
 
     explicit value(
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     );
+    // Takes over a reference to given location.
+    explicit value(location::id location);
+    ~value();
     value(const value&) = delete;
     value(value&&) = delete;
     void operator=(const value&) = delete;
@@ -40,22 +62,249 @@ namespace bali
 
     virtual enum type type() const = 0;
 
-    inline const std::optional<int>& line() const
+    inline std::optional<int> line() const
     {
-      return m_line;
+      return location::line(m_location);
     }
 
-    inline const std::optional<int>& column() const
+    inline std::optional<int> column() const
     {
-      return m_column;
+      return location::column(m_location);
     }
 
-  protected:
-    virtual std::u32string to_string() const = 0;
+    inline location::id location() const
+    {
+      return m_location;
+    }
+
+  private:
+    const location::id m_location;
+  };
+
+  /**
+   * Reference to a value. Atoms without source location that are small
+   * integers, floating point numbers whose two lowest bits are zero or
+   * symbols are stored in the reference itself instead of being allocated.
+   * Values are aligned to at least four bytes, which leaves the two lowest
+   * bits of pointers free for telling these immediate values apart.
+   */
+  class value::ptr
+  {
+  public:
+    using word_type = std::uintptr_t;
+
+    ptr(std::nullptr_t = nullptr)
+      : m_word(0) {}
+
+    template<
+      class T,
+      class = std::enable_if_t<std::is_base_of_v<value, T>>
+    >
+    ptr(const memory::ref<T>& that)
+      : m_word(to_word(that.get()))
+    {
+      retain();
+    }
+
+    template<
+      class T,
+      class = std::enable_if_t<std::is_base_of_v<value, T>>
+    >
+    ptr(memory::ref<T>&& that)
+      : m_word(to_word(that.detach())) {}
+
+    ptr(const ptr& that)
+      : m_word(that.m_word)
+    {
+      retain();
+    }
+
+    ptr(ptr&& that)
+      : m_word(that.m_word)
+    {
+      that.m_word = 0;
+    }
+
+    ~ptr()
+    {
+      if (m_word && !(m_word & tag_mask))
+      {
+        reinterpret_cast<const value*>(m_word)->release();
+      }
+    }
+
+    ptr& operator=(const ptr& that)
+    {
+      ptr(that).swap(*this);
+
+      return *this;
+    }
+
+    ptr& operator=(ptr&& that)
+    {
+      ptr(std::move(that)).swap(*this);
+
+      return *this;
+    }
+
+    // Integers are stored in the 62 highest bits.
+    static inline bool fits_integer(number::integer_type value)
+    {
+      return value >= -(number::integer_type(1) << 61) &&
+        value < (number::integer_type(1) << 61);
+    }
+
+    static inline bool fits_real(number::real_type value)
+    {
+      return !(to_bits(value) & tag_mask);
+    }
+
+    static inline ptr make_integer(number::integer_type value)
+    {
+      return ptr((static_cast<word_type>(value) << 2) | tag_integer);
+    }
+
+    static inline ptr make_real(number::real_type value)
+    {
+      return ptr(to_bits(value) | tag_real);
+    }
+
+    static inline ptr make_symbol(symbol::id id)
+    {
+      return ptr((static_cast<word_type>(id) << 2) | tag_symbol);
+    }
+
+    inline bool is_immediate() const
+    {
+      return m_word & tag_mask;
+    }
+
+    inline bool is_integer() const
+    {
+      return (m_word & tag_mask) == tag_integer;
+    }
+
+    inline bool is_real() const
+    {
+      return (m_word & tag_mask) == tag_real;
+    }
+
+    inline bool is_symbol() const
+    {
+      return (m_word & tag_mask) == tag_symbol;
+    }
+
+    inline number::integer_type integer() const
+    {
+      return static_cast<number::integer_type>(m_word) >> 2;
+    }
+
+    inline number::real_type real() const
+    {
+      number::real_type result;
+      const std::uint64_t bits = m_word & ~tag_mask;
+
+      std::memcpy(&result, &bits, sizeof(result));
+
+      return result;
+    }
+
+    inline symbol::id symbol() const
+    {
+      return static_cast<symbol::id>(m_word >> 2);
+    }
+
+    // Immediate values are all seen as the same atom without location
+    // through the pointer, which tells only their type. Casts into atoms
+    // allocate atoms with their contents instead.
+    inline value* get() const
+    {
+      return m_word & tag_mask ? prototype() : reinterpret_cast<value*>(m_word);
+    }
+
+    inline value& operator*() const
+    {
+      return *get();
+    }
+
+    inline value* operator->() const
+    {
+      return get();
+    }
+
+    inline explicit operator bool() const
+    {
+      return m_word != 0;
+    }
+
+    inline void reset()
+    {
+      ptr().swap(*this);
+    }
+
+    inline void swap(ptr& that)
+    {
+      std::swap(m_word, that.m_word);
+    }
+
+    // Returns the value as an atom, allocating one for immediate values.
+    // The value must be an atom.
+    memory::ref<atom> box() const;
+
+    // Returns true and stores the number into the slot if the value is an
+    // atom that is a number, without allocating an atom for it.
+    bool as_number(bali::number& slot) const;
+
+    friend inline bool operator==(const ptr& a, const ptr& b)
+    {
+      return a.m_word == b.m_word;
+    }
+
+    friend inline bool operator!=(const ptr& a, const ptr& b)
+    {
+      return a.m_word != b.m_word;
+    }
+
+  private:
+    enum : word_type
+    {
+      tag_integer = 1,
+      tag_symbol = 2,
+      tag_real = 3,
+      tag_mask = 3,
+    };
+
+    static_assert(sizeof(word_type) >= sizeof(std::uint64_t));
+
+    explicit ptr(word_type word)
+      : m_word(word) {}
+
+    static inline word_type to_word(const value* pointer)
+    {
+      return reinterpret_cast<word_type>(pointer);
+    }
+
+    static inline word_type to_bits(number::real_type value)
+    {
+      std::uint64_t bits;
+
+      std::memcpy(&bits, &value, sizeof(bits));
+
+      return bits;
+    }
+
+    static value* prototype();
+
+    inline void retain() const
+    {
+      if (m_word && !(m_word & tag_mask))
+      {
+        reinterpret_cast<const value*>(m_word)->retain();
+      }
+    }
 
   private:
-    const std::optional<int> m_line;
-    const std::optional<int> m_column;
+    word_type m_word;
   };
 
   class value::atom final : public value
@@ -64,28 +313,75 @@ namespace bali
     using value_type = std::u32string;
     using const_reference = const value_type&;
 
-    static inline std::shared_ptr<atom> make(
+    // Location of a variable within the slots of nested scopes, relative to
+    // the scope where the atom is evaluated.
+    struct lexical_address
+    {
+      std::uint32_t depth;
+      std::uint32_t index;
+    };
+
+    static inline memory::ref<atom> make(
       const_reference symbol,
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     )
     {
-      return std::shared_ptr<atom>(new atom(symbol, line, column));
+      return memory::ref<atom>(
+        new atom(symbol::intern(symbol), location::make(line, column))
+      );
     }
 
-    static inline std::shared_ptr<atom> make_bool(
-      bool value,
+    static inline memory::ref<atom> make(
+      symbol::id id,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    )
+    {
+      return memory::ref<atom>(new atom(id, location::make(line, column)));
+    }
+
+    // Creates atom that has the same source location as given value.
+    static inline memory::ref<atom> make(symbol::id id, const value& origin)
+    {
+      return memory::ref<atom>(
+        new atom(id, location::retain(origin.location()))
+      );
+    }
+
+    static inline memory::ref<atom> make(
+      symbol::id id,
+      const lexical_address& address,
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     )
     {
-      return value
-        ? std::shared_ptr<atom>(new atom(U"true", line, column))
-        : nullptr;
+      return memory::ref<atom>(
+        new atom(id, address, location::make(line, column))
+      );
+    }
+
+    static inline memory::ref<atom> make(
+      symbol::id id,
+      const lexical_address& address,
+      const value& origin
+    )
+    {
+      return memory::ref<atom>(
+        new atom(id, address, location::retain(origin.location()))
+      );
     }
 
-    static std::shared_ptr<atom> make_number(
-      double value,
+    // Values without source location are stored in the reference whenever
+    // possible, instead of being allocated.
+    static ptr make_bool(
+      bool value,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    );
+
+    static ptr make_number(
+      const bali::number& value,
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     );
@@ -95,26 +391,51 @@ namespace bali
       return type::atom;
     }
 
-    inline const_reference symbol() const
+    inline bool is_interned() const
     {
-      return m_symbol;
+      return m_id.has_value();
     }
 
-  protected:
-    inline std::u32string to_string() const
+    inline bool is_nil() const
+    {
+      return m_id && *m_id == symbol::nil;
+    }
+
+    inline const std::optional<lexical_address>& address() const
     {
-      return m_symbol;
+      return m_address;
     }
 
+    const_reference symbol() const;
+    symbol::id id() const;
+    bool number(bali::number& slot) const;
+
   private:
+    enum class number_state
+    {
+      unknown,
+      not_a_number,
+      number,
+    };
+
+    friend class value::ptr;
+
+    explicit atom(symbol::id id, location::id location);
+
     explicit atom(
-      const_reference symbol,
-      const std::optional<int>& line,
-      const std::optional<int>& column
+      symbol::id id,
+      const lexical_address& address,
+      location::id location
     );
 
+    explicit atom(const bali::number& number, location::id location);
+
   private:
-    const value_type m_symbol;
+    mutable std::optional<symbol::id> m_id;
+    const std::optional<lexical_address> m_address;
+    mutable std::optional<value_type> m_symbol;
+    mutable number_state m_number_state;
+    mutable bali::number m_number;
   };
 
   class value::list final : public value
@@ -123,15 +444,100 @@ namespace bali
     using value_type = ptr;
     using container_type = std::vector<value_type>;
     using size_type = container_type::size_type;
-    using iterator = container_type::const_iterator;
+    // Arguments are passed to functions as a view of pointers into the
+    // underlying storage, so that they don't have to be copied.
+    using iterator = const value_type*;
+
+    // Non-owning view of the elements of a list. It is valid only as long
+    // as the list itself is alive.
+    class view
+    {
+    public:
+      explicit view(iterator begin, iterator end)
+        : m_begin(begin)
+        , m_end(end) {}
 
-    static inline std::shared_ptr<list> make(
+      inline iterator begin() const
+      {
+        return m_begin;
+      }
+
+      inline iterator end() const
+      {
+        return m_end;
+      }
+
+      inline iterator data() const
+      {
+        return m_begin;
+      }
+
+      inline size_type size() const
+      {
+        return static_cast<size_type>(m_end - m_begin);
+      }
+
+      inline bool empty() const
+      {
+        return m_begin == m_end;
+      }
+
+      inline const value_type& operator[](size_type index) const
+      {
+        return m_begin[index];
+      }
+
+    private:
+      iterator m_begin;
+      iterator m_end;
+    };
+
+    static inline memory::ref<list> make(
       const container_type& elements,
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     )
     {
-      return std::shared_ptr<list>(new list(elements, line, column));
+      return make(container_type(elements), line, column);
+    }
+
+    static inline memory::ref<list> make(
+      container_type&& elements,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    )
+    {
+      if (elements.empty() && !line && !column)
+      {
+        return make_empty();
+      }
+
+      return allocate(std::move(elements), location::make(line, column));
+    }
+
+    // Creates list that has the same source location as given value.
+    static inline memory::ref<list> make(
+      const container_type& elements,
+      const value& origin
+    )
+    {
+      return make(container_type(elements), origin);
+    }
+
+    static inline memory::ref<list> make(
+      container_type&& elements,
+      const value& origin
+    )
+    {
+      if (elements.empty() && origin.location() == location::id::none)
+      {
+        return make_empty();
+      }
+
+      return allocate(
+        std::move(elements),
+        location::retain(origin.location())
+      );
     }
 
     inline enum type type() const
@@ -139,23 +545,440 @@ namespace bali
       return type::list;
     }
 
-    inline const container_type& elements() const
+    inline view elements() const
     {
-      return m_elements;
+      if (!m_buffer)
+      {
+        return view(m_inline, m_inline + m_offset);
+      }
+
+      const auto data = m_buffer->elements.data();
+
+      return view(data + m_offset, data + m_buffer->elements.size());
     }
 
-  protected:
-    std::u32string to_string() const;
+    inline size_type size() const
+    {
+      return m_buffer ? m_buffer->elements.size() - m_offset : m_offset;
+    }
+
+    inline bool empty() const
+    {
+      return size() == 0;
+    }
+
+    // Returns the list without its first element, sharing the elements with
+    // this list. The list must not be empty.
+    memory::ref<list> rest() const;
+
+    // Returns new list that consists of given elements followed by elements
+    // of this list. Elements of this list are shared whenever possible, so
+    // prepending single element is amortized O(1).
+    memory::ref<list> prepend(iterator begin, iterator end) const;
 
   private:
+    // Returns shared constant empty list.
+    static const memory::ref<list>& make_empty();
+
+    // Allocates list that takes over a reference to given location.
+    static memory::ref<list> allocate(
+      container_type&& elements,
+      location::id location
+    );
+
+    // Lists that have at most this many elements store them inline, which
+    // covers most of the call forms in parsed programs.
+    static constexpr size_type inline_capacity = 4;
+
+    // Storage shared by lists. Elements are kept at the end of the buffer,
+    // and lists grow towards its beginning. Slots before `first` are unused
+    // and the list that begins at `first` can claim them without copying.
+    struct buffer : public memory::counted
+    {
+      explicit buffer(container_type&& elements = container_type())
+        : elements(std::move(elements))
+        , first(0) {}
+
+      container_type elements;
+      size_type first;
+    };
+
     explicit list(
-      const container_type& elements,
+      const memory::ref<buffer>& buffer,
+      size_type offset,
+      location::id location
+    );
+
+    // Constructs list with inline storage from concatenation of two ranges.
+    explicit list(
+      iterator first_begin,
+      iterator first_end,
+      iterator second_begin,
+      iterator second_end,
+      location::id location
+    );
+
+  private:
+    // Lists with inline storage have no buffer, and their offset is the
+    // number of elements.
+    const memory::ref<buffer> m_buffer;
+    const size_type m_offset;
+    value_type m_inline[inline_capacity];
+  };
+
+  /**
+   * Packed array of numbers that are either all 64-bit integers or all
+   * floating point numbers.
+   */
+  class value::array final : public value
+  {
+  public:
+    using integer_container_type = std::vector<number::integer_type>;
+    using real_container_type = std::vector<number::real_type>;
+    using size_type = std::size_t;
+
+    static inline memory::ref<array> make(
+      integer_container_type&& elements,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    )
+    {
+      return memory::ref<array>(new array(
+        std::move(elements),
+        real_container_type(),
+        true,
+        line,
+        column
+      ));
+    }
+
+    static inline memory::ref<array> make(
+      real_container_type&& elements,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    )
+    {
+      return memory::ref<array>(new array(
+        integer_container_type(),
+        std::move(elements),
+        false,
+        line,
+        column
+      ));
+    }
+
+    inline enum type type() const
+    {
+      return type::array;
+    }
+
+    inline bool is_integer() const
+    {
+      return m_is_integer;
+    }
+
+    inline size_type size() const
+    {
+      return m_is_integer ? m_integers.size() : m_reals.size();
+    }
+
+    // Elements of integer array. Empty for arrays of floating point
+    // numbers.
+    inline const integer_container_type& integers() const
+    {
+      return m_integers;
+    }
+
+    // Elements of floating point array. Empty for integer arrays.
+    inline const real_container_type& reals() const
+    {
+      return m_reals;
+    }
+
+    inline bali::number at(size_type index) const
+    {
+      if (m_is_integer)
+      {
+        return m_integers[index];
+      }
+
+      return m_reals[index];
+    }
+
+    memory::ref<array> slice(size_type begin, size_type end) const;
+
+  private:
+    explicit array(
+      integer_container_type&& integers,
+      real_container_type&& reals,
+      bool is_integer,
+      const std::optional<int>& line,
+      const std::optional<int>& column
+    );
+
+  private:
+    const integer_container_type m_integers;
+    const real_container_type m_reals;
+    const bool m_is_integer;
+  };
+
+  /**
+   * Persistent vector with effectively constant time indexed access. The
+   * elements are stored in a tree where each node has 32 children, and
+   * modified vectors share all of the nodes except those on the path to the
+   * modified element. Slices share the whole tree.
+   */
+  class value::vector final : public value
+  {
+  public:
+    using value_type = ptr;
+    using size_type = std::size_t;
+    using iterator = value::list::iterator;
+
+    static memory::ref<vector> make(
+      iterator begin,
+      iterator end,
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    );
+
+    inline enum type type() const
+    {
+      return type::vector;
+    }
+
+    inline size_type size() const
+    {
+      return m_size;
+    }
+
+    const value_type& at(size_type index) const;
+
+    // Returns new vector where element at given index has been replaced.
+    memory::ref<vector> set(size_type index, const value_type& value) const;
+
+    memory::ref<vector> slice(size_type begin, size_type end) const;
+
+  private:
+    static constexpr unsigned bits = 5;
+    static constexpr size_type width = size_type(1) << bits;
+    static constexpr size_type mask = width - 1;
+
+    struct node : public memory::counted {};
+
+    struct branch : public node
+    {
+      memory::ref<node> children[width];
+    };
+
+    struct leaf : public node
+    {
+      value_type values[width];
+    };
+
+    static memory::ref<node> set(
+      const memory::ref<node>& node,
+      unsigned shift,
+      size_type index,
+      const value_type& value
+    );
+
+    explicit vector(
+      const memory::ref<node>& root,
+      unsigned shift,
+      size_type offset,
+      size_type size,
       const std::optional<int>& line,
       const std::optional<int>& column
     );
 
   private:
-    const container_type m_elements;
+    const memory::ref<node> m_root;
+    // Number of bits the index is shifted right to get the index of the
+    // child in the root node. Zero when the root is a leaf.
+    const unsigned m_shift;
+    const size_type m_offset;
+    const size_type m_size;
+  };
+
+  /**
+   * Persistent hash map, implemented as hash array mapped trie. Keys are
+   * compared structurally: numbers by their numeric value, other atoms by
+   * their symbol and lists and vectors by their elements.
+   */
+  class value::map final : public value
+  {
+  public:
+    using value_type = ptr;
+    using size_type = std::size_t;
+    using hash_type = std::size_t;
+
+    static memory::ref<map> make(
+      const std::optional<int>& line = std::nullopt,
+      const std::optional<int>& column = std::nullopt
+    );
+
+    static hash_type hash(const value_type& key);
+    static bool equals(const value_type& a, const value_type& b);
+
+    inline enum type type() const
+    {
+      return type::map;
+    }
+
+    inline size_type size() const
+    {
+      return m_size;
+    }
+
+    // Returns pointer to the value associated with given key, or null
+    // pointer if the map does not contain the key.
+    const value_type* find(const value_type& key) const;
+
+    memory::ref<map> assoc(
+      const value_type& key,
+      const value_type& value
+    ) const;
+
+    memory::ref<map> dissoc(const value_type& key) const;
+
+    // Calls given callback for each key and value in the map.
+    template<class Callback>
+    inline void for_each(Callback callback) const
+    {
+      if (m_root)
+      {
+        for_each(*m_root, callback);
+      }
+    }
+
+  private:
+    using entry = std::pair<value_type, value_type>;
+
+    // Node stores entries whose hashes end in unique bits on the node's
+    // level directly, and those with shared bits in child nodes. Nodes
+    // below the level where the hash runs out of bits store all their
+    // entries in a plain list.
+    struct node : public memory::counted
+    {
+      std::uint32_t entry_map = 0;
+      std::uint32_t child_map = 0;
+      std::vector<entry> entries;
+      std::vector<memory::ref<node>> children;
+    };
+
+    template<class Callback>
+    static inline void for_each(const node& current, Callback& callback)
+    {
+      for (const auto& entry : current.entries)
+      {
+        callback(entry.first, entry.second);
+      }
+      for (const auto& child : current.children)
+      {
+        for_each(*child, callback);
+      }
+    }
+
+    static memory::ref<node> assoc(
+      const memory::ref<node>& node,
+      unsigned shift,
+      hash_type hash,
+      const entry& entry,
+      bool& added
+    );
+
+    static memory::ref<node> merge(
+      const entry& a,
+      hash_type a_hash,
+      const entry& b,
+      hash_type b_hash,
+      unsigned shift
+    );
+
+    static memory::ref<node> dissoc(
+      const memory::ref<node>& node,
+      unsigned shift,
+      hash_type hash,
+      const value_type& key,
+      bool& removed
+    );
+
+    explicit map(
+      const memory::ref<node>& root,
+      size_type size,
+      const std::optional<int>& line,
+      const std::optional<int>& column
+    );
+
+  private:
+    const memory::ref<node> m_root;
+    const size_type m_size;
+  };
+
+  /**
+   * Lazy sequence, whose elements are computed only when the sequence is
+   * iterated. Sequences are immutable descriptions of pipelines, so they can
+   * be iterated any number of times.
+   */
+  class value::sequence final : public value
+  {
+  public:
+    using size_type = std::size_t;
+
+    // Produces elements of the sequence one by one.
+    class cursor
+    {
+    public:
+      virtual ~cursor() = default;
+
+      // Stores next element into given slot, or returns false if the
+      // sequence has been exhausted.
+      virtual bool next(
+        value::ptr& slot,
+        const memory::ref<class scope>& scope
+      ) = 0;
+    };
+
+    // Single step of the pipeline, defined in the implementation.
+    class stage;
+
+    // Sequence of numbers from start up to, but not including, end. Sequence
+    // without end is infinite.
+    static memory::ref<sequence> make_range(
+      const bali::number& start,
+      const std::optional<bali::number>& end,
+      const bali::number& step
+    );
+
+    // Sequence of elements of a list or a vector.
+    static memory::ref<sequence> make_elements(const value::ptr& collection);
+
+    ~sequence();
+
+    inline enum type type() const
+    {
+      return type::sequence;
+    }
+
+    memory::ref<sequence> map(
+      const memory::ref<function>& callback
+    ) const;
+    memory::ref<sequence> filter(
+      const memory::ref<function>& callback
+    ) const;
+    memory::ref<sequence> take(size_type count) const;
+    memory::ref<sequence> take_while(
+      const memory::ref<function>& callback
+    ) const;
+
+    std::unique_ptr<cursor> iterate() const;
+
+  private:
+    explicit sequence(const memory::ref<stage>& stage);
+
+  private:
+    const memory::ref<stage> m_stage;
   };
 
   class value::function : public value
@@ -175,8 +998,9 @@ namespace bali
     }
 
     virtual value::ptr call(
-      const value::list::container_type& arguments,
-      const std::shared_ptr<class scope>& scope
+      const value::list::iterator& begin,
+      const value::list::iterator& end,
+      const memory::ref<class scope>& scope
     ) const = 0;
 
   protected:
@@ -193,27 +1017,42 @@ namespace bali
   class value::function::builtin final : public value::function
   {
   public:
+    // Builtin functions that are called in tail position can leave their
+    // resulting expression for the caller to evaluate, instead of
+    // evaluating it themselves.
+    struct tail_expression
+    {
+      value::ptr expression;
+      memory::ref<class scope> scope;
+    };
+
     using callback_type = value::ptr(*)(
       value::list::iterator&,
       const value::list::iterator&,
-      const std::shared_ptr<class scope>&
+      const memory::ref<class scope>&,
+      tail_expression*
     );
 
-    static inline std::shared_ptr<builtin> make(
+    static inline memory::ref<builtin> make(
       callback_type callback,
       const std::u32string& name
     )
     {
-      return std::shared_ptr<builtin>(new builtin(callback, name));
+      return memory::ref<builtin>(new builtin(callback, name));
     }
 
     value::ptr call(
-      const value::list::container_type& arguments,
-      const std::shared_ptr<class scope>& scope
+      const value::list::iterator& begin,
+      const value::list::iterator& end,
+      const memory::ref<class scope>& scope
     ) const;
 
-  protected:
-    std::u32string to_string() const;
+    value::ptr call(
+      const value::list::iterator& begin,
+      const value::list::iterator& end,
+      const memory::ref<class scope>& scope,
+      tail_expression* tail
+    ) const;
 
   private:
     builtin(callback_type callback, const std::u32string& name);
@@ -225,16 +1064,16 @@ namespace bali
   class value::function::custom final : public value::function
   {
   public:
-    static inline std::shared_ptr<custom>
+    static inline memory::ref<custom>
     make(
-      const std::vector<std::u32string>& parameters,
+      const std::vector<symbol::id>& parameters,
       const ptr& expression,
       const std::optional<std::u32string>& name = std::nullopt,
       const std::optional<int>& line = std::nullopt,
       const std::optional<int>& column = std::nullopt
     )
     {
-      return std::shared_ptr<custom>(new custom(
+      return memory::ref<custom>(new custom(
         parameters,
         expression,
         name,
@@ -243,17 +1082,44 @@ namespace bali
       ));
     }
 
+    inline const std::vector<symbol::id>& parameters() const
+    {
+      return m_parameters;
+    }
+
+    inline const ptr& expression() const
+    {
+      return m_expression;
+    }
+
+    // Creates scope for calling the function with given arguments. If
+    // evaluation scope is given, the arguments are evaluated in it directly
+    // into the created scope.
+    memory::ref<class scope> bind(
+      const value::list::iterator& begin,
+      const value::list::iterator& end,
+      const memory::ref<class scope>& scope,
+      const memory::ref<class scope>& evaluation_scope = nullptr
+    ) const;
+
     value::ptr call(
-      const value::list::container_type& arguments,
-      const std::shared_ptr<class scope>& scope
+      const value::list::iterator& begin,
+      const value::list::iterator& end,
+      const memory::ref<class scope>& scope
     ) const;
 
-  protected:
-    std::u32string to_string() const;
+    // Executes the function in scope created with bind(), where scope is the
+    // scope where the function was called from.
+    value::ptr execute(
+      const memory::ref<class scope>& function_scope,
+      const memory::ref<class scope>& scope
+    ) const;
+
+    const bytecode::program& compile() const;
 
   private:
     explicit custom(
-      const std::vector<std::u32string>& parameters,
+      const std::vector<symbol::id>& parameters,
       const ptr& expression,
       const std::optional<std::u32string>& name,
       const std::optional<int>& line,
@@ -261,9 +1127,41 @@ namespace bali
     );
 
   private:
-    const std::vector<std::u32string> m_parameters;
+    const std::vector<symbol::id> m_parameters;
     const ptr m_expression;
+    mutable std::shared_ptr<bytecode::program> m_program;
   };
 
   std::ostream& operator<<(std::ostream& os, const value::ptr& value);
+
+  namespace memory
+  {
+    // Immediate values are atoms, which are allocated when they are cast
+    // into one.
+    template<class T>
+    inline ref<T> static_pointer_cast(const value::ptr& that)
+    {
+      if (that.is_immediate())
+      {
+        return ref<T>(static_cast<T*>(static_cast<value*>(
+          that.box().get()
+        )));
+      }
+
+      return ref<T>(static_cast<T*>(that.get()));
+    }
+
+    template<class T>
+    inline ref<T> dynamic_pointer_cast(const value::ptr& that)
+    {
+      if (that.is_immediate())
+      {
+        return ref<T>(dynamic_cast<T*>(static_cast<value*>(
+          that.box().get()
+        )));
+      }
+
+      return ref<T>(dynamic_cast<T*>(that.get()));
+    }
+  }
 }
@@ -0,0 +1,690 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <bali/bignum.hpp>
+
+#if !defined(BALI_KARATSUBA_THRESHOLD)
+# define BALI_KARATSUBA_THRESHOLD 32
+#endif
+
+#if !defined(BALI_DECIMAL_THRESHOLD)
+# define BALI_DECIMAL_THRESHOLD 32
+#endif
+
+namespace bali
+{
+  using limb_type = bignum::limb_type;
+  using container_type = bignum::container_type;
+  using size_type = container_type::size_type;
+  using wide_type = std::uint64_t;
+  using signed_wide_type = std::int64_t;
+
+  static const limb_type decimal_base = 1000000000;
+  static const int decimal_base_digits = 9;
+
+  static inline void
+  trim(container_type& limbs)
+  {
+    while (!limbs.empty() && !limbs.back())
+    {
+      limbs.pop_back();
+    }
+  }
+
+  static int
+  compare_magnitude(const container_type& a, const container_type& b)
+  {
+    if (a.size() != b.size())
+    {
+      return a.size() < b.size() ? -1 : 1;
+    }
+    for (auto i = a.size(); i > 0; --i)
+    {
+      if (a[i - 1] != b[i - 1])
+      {
+        return a[i - 1] < b[i - 1] ? -1 : 1;
+      }
+    }
+
+    return 0;
+  }
+
+  // Adds b into a, shifted left by given number of limbs.
+  static void
+  add_magnitude_to(
+    container_type& a,
+    const container_type& b,
+    size_type shift
+  )
+  {
+    wide_type carry = 0;
+    size_type i = 0;
+
+    if (a.size() < b.size() + shift)
+    {
+      a.resize(b.size() + shift, 0);
+    }
+    for (; i < b.size(); ++i)
+    {
+      carry += static_cast<wide_type>(a[i + shift]) + b[i];
+      a[i + shift] = static_cast<limb_type>(carry);
+      carry >>= 32;
+    }
+    for (i += shift; carry; ++i)
+    {
+      if (i == a.size())
+      {
+        a.push_back(0);
+      }
+      carry += a[i];
+      a[i] = static_cast<limb_type>(carry);
+      carry >>= 32;
+    }
+  }
+
+  // Subtracts b from a, which must not be smaller than b.
+  static void
+  subtract_magnitude_from(container_type& a, const container_type& b)
+  {
+    signed_wide_type borrow = 0;
+
+    for (size_type i = 0; i < a.size(); ++i)
+    {
+      if (i >= b.size() && !borrow)
+      {
+        break;
+      }
+      borrow += static_cast<signed_wide_type>(a[i]);
+      if (i < b.size())
+      {
+        borrow -= b[i];
+      }
+      a[i] = static_cast<limb_type>(borrow);
+      borrow = borrow < 0 ? -1 : 0;
+    }
+    trim(a);
+  }
+
+  static container_type
+  multiply_schoolbook(const container_type& a, const container_type& b)
+  {
+    container_type result(a.size() + b.size(), 0);
+
+    for (size_type i = 0; i < a.size(); ++i)
+    {
+      wide_type carry = 0;
+
+      for (size_type j = 0; j < b.size(); ++j)
+      {
+        carry += static_cast<wide_type>(a[i]) * b[j] + result[i + j];
+        result[i + j] = static_cast<limb_type>(carry);
+        carry >>= 32;
+      }
+      result[i + b.size()] = static_cast<limb_type>(carry);
+    }
+    trim(result);
+
+    return result;
+  }
+
+  static inline container_type
+  slice(const container_type& limbs, size_type begin, size_type end)
+  {
+    begin = std::min(begin, limbs.size());
+    end = std::min(end, limbs.size());
+
+    container_type result(
+      std::begin(limbs) + begin,
+      std::begin(limbs) + end
+    );
+
+    trim(result);
+
+    return result;
+  }
+
+  // Karatsuba multiplication, which splits both operands into high and low
+  // halves and replaces one of the four half sized multiplications with
+  // additions and subtractions.
+  static container_type
+  multiply_magnitude(const container_type& a, const container_type& b)
+  {
+    const auto smaller = std::min(a.size(), b.size());
+    const auto larger = std::max(a.size(), b.size());
+
+    if (!smaller)
+    {
+      return container_type();
+    }
+    else if (smaller < BALI_KARATSUBA_THRESHOLD)
+    {
+      return multiply_schoolbook(a, b);
+    }
+
+    const auto half = (larger + 1) / 2;
+
+    // Unbalanced operands are multiplied piecewise, to keep the halves of
+    // the smaller operand from being empty.
+    if (smaller <= half)
+    {
+      const auto& large = a.size() > b.size() ? a : b;
+      const auto& small = a.size() > b.size() ? b : a;
+      container_type result;
+
+      for (size_type i = 0; i < large.size(); i += small.size())
+      {
+        add_magnitude_to(
+          result,
+          multiply_magnitude(slice(large, i, i + small.size()), small),
+          i
+        );
+      }
+      trim(result);
+
+      return result;
+    }
+
+    const auto a_low = slice(a, 0, half);
+    const auto a_high = slice(a, half, a.size());
+    const auto b_low = slice(b, 0, half);
+    const auto b_high = slice(b, half, b.size());
+    const auto low = multiply_magnitude(a_low, b_low);
+    const auto high = multiply_magnitude(a_high, b_high);
+    auto a_sum = a_low;
+    auto b_sum = b_low;
+    container_type result;
+
+    add_magnitude_to(a_sum, a_high, 0);
+    add_magnitude_to(b_sum, b_high, 0);
+
+    auto middle = multiply_magnitude(a_sum, b_sum);
+
+    subtract_magnitude_from(middle, low);
+    subtract_magnitude_from(middle, high);
+    result = low;
+    add_magnitude_to(result, middle, half);
+    add_magnitude_to(result, high, half * 2);
+    trim(result);
+
+    return result;
+  }
+
+  // Divides the magnitude by single limb in place and returns the
+  // remainder.
+  static limb_type
+  divide_magnitude_by_limb(container_type& limbs, limb_type divider)
+  {
+    wide_type remainder = 0;
+
+    for (auto i = limbs.size(); i > 0; --i)
+    {
+      const auto current = (remainder << 32) | limbs[i - 1];
+
+      limbs[i - 1] = static_cast<limb_type>(current / divider);
+      remainder = current % divider;
+    }
+    trim(limbs);
+
+    return static_cast<limb_type>(remainder);
+  }
+
+  static inline int
+  leading_zeroes(limb_type limb)
+  {
+    int result = 0;
+
+    while (!(limb & 0x80000000))
+    {
+      limb <<= 1;
+      ++result;
+    }
+
+    return result;
+  }
+
+  // Long division from Knuth's The Art of Computer Programming, volume 2,
+  // algorithm D. Divider must not be zero.
+  static void
+  divide_magnitude(
+    const container_type& u,
+    const container_type& v,
+    container_type& quotient,
+    container_type& remainder
+  )
+  {
+    if (compare_magnitude(u, v) < 0)
+    {
+      quotient.clear();
+      remainder = u;
+      return;
+    }
+    else if (v.size() == 1)
+    {
+      quotient = u;
+      remainder.clear();
+      if (const auto rest = divide_magnitude_by_limb(quotient, v[0]))
+      {
+        remainder.push_back(rest);
+      }
+      return;
+    }
+
+    const auto m = u.size();
+    const auto n = v.size();
+    const auto shift = leading_zeroes(v.back());
+    const wide_type base = wide_type(1) << 32;
+    container_type vn(n);
+    container_type un(m + 1);
+
+    // Normalize so that the highest limb of the divider has its highest bit
+    // set, which keeps the estimated quotient digits within two of the
+    // actual ones.
+    for (size_type i = n - 1; i > 0; --i)
+    {
+      vn[i] = shift
+        ? (v[i] << shift) | (v[i - 1] >> (32 - shift))
+        : v[i];
+    }
+    vn[0] = v[0] << shift;
+    un[m] = shift ? u[m - 1] >> (32 - shift) : 0;
+    for (size_type i = m - 1; i > 0; --i)
+    {
+      un[i] = shift
+        ? (u[i] << shift) | (u[i - 1] >> (32 - shift))
+        : u[i];
+    }
+    un[0] = u[0] << shift;
+
+    quotient.assign(m - n + 1, 0);
+    for (auto j = m - n + 1; j > 0; --j)
+    {
+      const auto k = j - 1;
+      const auto numerator = (static_cast<wide_type>(un[k + n]) << 32)
+        | un[k + n - 1];
+      auto estimate = numerator / vn[n - 1];
+      auto rest = numerator % vn[n - 1];
+      signed_wide_type borrow = 0;
+      signed_wide_type difference;
+
+      while (
+        estimate >= base ||
+        estimate * vn[n - 2] > ((rest << 32) | un[k + n - 2])
+      )
+      {
+        --estimate;
+        rest += vn[n - 1];
+        if (rest >= base)
+        {
+          break;
+        }
+      }
+
+      for (size_type i = 0; i < n; ++i)
+      {
+        const auto product = estimate * vn[i];
+
+        difference = static_cast<signed_wide_type>(un[i + k])
+          - borrow
+          - static_cast<signed_wide_type>(product & 0xffffffff);
+        un[i + k] = static_cast<limb_type>(difference);
+        borrow = static_cast<signed_wide_type>(product >> 32)
+          - (difference >> 32);
+      }
+      difference = static_cast<signed_wide_type>(un[k + n]) - borrow;
+      un[k + n] = static_cast<limb_type>(difference);
+
+      // Estimate was one too large, so add the divider back.
+      if (difference < 0)
+      {
+        wide_type carry = 0;
+
+        --estimate;
+        for (size_type i = 0; i < n; ++i)
+        {
+          carry += static_cast<wide_type>(un[i + k]) + vn[i];
+          un[i + k] = static_cast<limb_type>(carry);
+          carry >>= 32;
+        }
+        un[k + n] += static_cast<limb_type>(carry);
+      }
+      quotient[k] = static_cast<limb_type>(estimate);
+    }
+    trim(quotient);
+
+    remainder.resize(n);
+    for (size_type i = 0; i < n; ++i)
+    {
+      remainder[i] = shift
+        ? (un[i] >> shift) | (un[i + 1] << (32 - shift))
+        : un[i];
+    }
+    trim(remainder);
+  }
+
+  // Adds two signed magnitudes. Sign of the first one is replaced with the
+  // sign of the result.
+  static container_type
+  add_signed(
+    const container_type& a,
+    const container_type& b,
+    bool& a_negative,
+    bool b_negative
+  )
+  {
+    container_type result;
+
+    if (a_negative == b_negative)
+    {
+      result = a;
+      add_magnitude_to(result, b, 0);
+    }
+    else if (compare_magnitude(a, b) < 0)
+    {
+      result = b;
+      subtract_magnitude_from(result, a);
+      a_negative = b_negative;
+    } else {
+      result = a;
+      subtract_magnitude_from(result, b);
+    }
+
+    return result;
+  }
+
+  // Returns 10^(9 * 2^index), computed by repeated squaring and cached for
+  // the lifetime of the program.
+  static const container_type&
+  decimal_power(size_type index)
+  {
+    static std::vector<container_type> powers;
+
+    if (powers.empty())
+    {
+      powers.push_back(container_type{ decimal_base });
+    }
+    while (powers.size() <= index)
+    {
+      const auto& last = powers.back();
+
+      powers.push_back(multiply_magnitude(last, last));
+    }
+
+    return powers[index];
+  }
+
+  static void
+  append_chunk(std::u32string& output, limb_type chunk, bool pad)
+  {
+    char32_t buffer[decimal_base_digits];
+    int length = 0;
+
+    do
+    {
+      buffer[length++] = U'0' + chunk % 10;
+      chunk /= 10;
+    }
+    while (chunk);
+    if (pad)
+    {
+      while (length < decimal_base_digits)
+      {
+        buffer[length++] = U'0';
+      }
+    }
+    while (length > 0)
+    {
+      output.push_back(buffer[--length]);
+    }
+  }
+
+  // Divide and conquer conversion into decimal. The magnitude is split with
+  // the largest cached power of ten that is no longer than half of it, so
+  // that both halves can be converted independently. When padding is
+  // requested, the output is padded with leading zeroes to given number of
+  // digits.
+  static void
+  append_decimal(
+    std::u32string& output,
+    const container_type& limbs,
+    size_type padding
+  )
+  {
+    if (limbs.size() <= BALI_DECIMAL_THRESHOLD)
+    {
+      std::vector<limb_type> chunks;
+      std::u32string digits;
+      auto rest = limbs;
+
+      while (!rest.empty())
+      {
+        chunks.push_back(divide_magnitude_by_limb(rest, decimal_base));
+      }
+      for (auto i = chunks.size(); i > 0; --i)
+      {
+        append_chunk(digits, chunks[i - 1], i != chunks.size());
+      }
+      if (padding > digits.length())
+      {
+        output.append(padding - digits.length(), U'0');
+      }
+      output.append(digits);
+      return;
+    }
+
+    size_type index = 0;
+    container_type high;
+    container_type low;
+
+    while (decimal_power(index + 1).size() * 2 <= limbs.size())
+    {
+      ++index;
+    }
+    divide_magnitude(limbs, decimal_power(index), high, low);
+
+    const auto low_digits = (size_type(decimal_base_digits) << index);
+
+    append_decimal(
+      output,
+      high,
+      padding > low_digits ? padding - low_digits : 0
+    );
+    append_decimal(output, low, low_digits);
+  }
+
+  bignum::bignum(bool negative, container_type&& limbs)
+    : m_negative(negative)
+    , m_limbs(std::move(limbs)) {}
+
+  bignum::ptr
+  bignum::make(bool negative, container_type&& limbs)
+  {
+    trim(limbs);
+
+    return ptr(new bignum(negative && !limbs.empty(), std::move(limbs)));
+  }
+
+  bignum::ptr
+  bignum::make(std::int64_t value)
+  {
+    // Negation is done in unsigned arithmetic, so that the smallest integer
+    // does not overflow.
+    const auto magnitude = value < 0
+      ? ~static_cast<std::uint64_t>(value) + 1
+      : static_cast<std::uint64_t>(value);
+
+    return make(
+      value < 0,
+      container_type{
+        static_cast<limb_type>(magnitude),
+        static_cast<limb_type>(magnitude >> 32)
+      }
+    );
+  }
+
+  bignum::ptr
+  bignum::parse(const std::u32string& text)
+  {
+    const auto length = text.length();
+    std::u32string::size_type i = 0;
+    bool negative = false;
+    container_type limbs;
+
+    if (text[0] == U'+' || text[0] == U'-')
+    {
+      negative = text[0] == U'-';
+      ++i;
+    }
+    while (i < length)
+    {
+      wide_type chunk = 0;
+      wide_type scale = 1;
+
+      for (int j = 0; j < decimal_base_digits && i < length; ++j, ++i)
+      {
+        chunk = chunk * 10 + (text[i] - U'0');
+        scale *= 10;
+      }
+      for (auto& limb : limbs)
+      {
+        chunk += limb * scale;
+        limb = static_cast<limb_type>(chunk);
+        chunk >>= 32;
+      }
+      if (chunk)
+      {
+        limbs.push_back(static_cast<limb_type>(chunk));
+      }
+    }
+
+    return make(negative, std::move(limbs));
+  }
+
+  bignum::ptr
+  bignum::add(const bignum& a, const bignum& b)
+  {
+    bool negative = a.m_negative;
+    auto limbs = add_signed(a.m_limbs, b.m_limbs, negative, b.m_negative);
+
+    return make(negative, std::move(limbs));
+  }
+
+  bignum::ptr
+  bignum::subtract(const bignum& a, const bignum& b)
+  {
+    bool negative = a.m_negative;
+    auto limbs = add_signed(a.m_limbs, b.m_limbs, negative, !b.m_negative);
+
+    return make(negative, std::move(limbs));
+  }
+
+  bignum::ptr
+  bignum::multiply(const bignum& a, const bignum& b)
+  {
+    return make(
+      a.m_negative != b.m_negative,
+      multiply_magnitude(a.m_limbs, b.m_limbs)
+    );
+  }
+
+  void
+  bignum::divide(
+    const bignum& a,
+    const bignum& b,
+    ptr& quotient,
+    ptr& remainder
+  )
+  {
+    container_type quotient_limbs;
+    container_type remainder_limbs;
+
+    divide_magnitude(a.m_limbs, b.m_limbs, quotient_limbs, remainder_limbs);
+    quotient = make(
+      a.m_negative != b.m_negative,
+      std::move(quotient_limbs)
+    );
+    remainder = make(a.m_negative, std::move(remainder_limbs));
+  }
+
+  int
+  bignum::compare(const bignum& a, const bignum& b)
+  {
+    if (a.m_negative != b.m_negative)
+    {
+      return a.m_negative ? -1 : 1;
+    }
+
+    const auto result = compare_magnitude(a.m_limbs, b.m_limbs);
+
+    return a.m_negative ? -result : result;
+  }
+
+  bignum::ptr
+  bignum::negate() const
+  {
+    return make(!m_negative, container_type(m_limbs));
+  }
+
+  bool
+  bignum::to_integer(std::int64_t& slot) const
+  {
+    using limits = std::numeric_limits<std::int64_t>;
+    std::uint64_t magnitude = 0;
+
+    if (m_limbs.size() > 2)
+    {
+      return false;
+    }
+    for (auto i = m_limbs.size(); i > 0; --i)
+    {
+      magnitude = (magnitude << 32) | m_limbs[i - 1];
+    }
+    if (m_negative)
+    {
+      if (magnitude > static_cast<std::uint64_t>(limits::max()) + 1)
+      {
+        return false;
+      }
+      slot = static_cast<std::int64_t>(~magnitude + 1);
+    }
+    else if (magnitude > static_cast<std::uint64_t>(limits::max()))
+    {
+      return false;
+    } else {
+      slot = static_cast<std::int64_t>(magnitude);
+    }
+
+    return true;
+  }
+
+  double
+  bignum::to_double() const
+  {
+    double result = 0;
+
+    for (auto i = m_limbs.size(); i > 0; --i)
+    {
+      result = result * 4294967296.0 + m_limbs[i - 1];
+    }
+
+    return m_negative ? -result : result;
+  }
+
+  std::u32string
+  bignum::to_string() const
+  {
+    std::u32string result;
+
+    if (m_limbs.empty())
+    {
+      return U"0";
+    }
+    else if (m_negative)
+    {
+      result.push_back(U'-');
+    }
+    append_decimal(result, m_limbs, 0);
+
+    return result;
+  }
+}
@@ -0,0 +1,933 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include <bali/bytecode.hpp>
+#include <bali/utils.hpp>
+
+namespace bali::bytecode
+{
+  bool enabled = false;
+
+  namespace
+  {
+    enum class form
+    {
+      quote,
+      if_,
+      and_,
+      or_,
+      not_,
+      setq,
+      let,
+      while_,
+      dotimes,
+      loop,
+      recur,
+      add,
+      subtract,
+      multiply,
+      divide,
+      eq,
+      lt,
+      gt,
+      lte,
+      gte,
+    };
+  }
+
+  static std::optional<form>
+  get_form(const value::ptr& head)
+  {
+    static const std::unordered_map<symbol::id, form> form_map =
+    {
+      { symbol::quote, form::quote },
+      { symbol::intern(U"if"), form::if_ },
+      { symbol::intern(U"and"), form::and_ },
+      { symbol::intern(U"or"), form::or_ },
+      { symbol::intern(U"not"), form::not_ },
+      { symbol::intern(U"setq"), form::setq },
+      { symbol::let, form::let },
+      { symbol::intern(U"while"), form::while_ },
+      { symbol::dotimes, form::dotimes },
+      { symbol::loop, form::loop },
+      { symbol::intern(U"recur"), form::recur },
+      { symbol::intern(U"+"), form::add },
+      { symbol::intern(U"-"), form::subtract },
+      { symbol::intern(U"*"), form::multiply },
+      { symbol::intern(U"/"), form::divide },
+      { symbol::intern(U"="), form::eq },
+      { symbol::intern(U"<"), form::lt },
+      { symbol::intern(U">"), form::gt },
+      { symbol::intern(U"<="), form::lte },
+      { symbol::intern(U">="), form::gte },
+    };
+
+    if (head && head->type() == value::type::atom)
+    {
+      const auto atom = memory::static_pointer_cast<value::atom>(head);
+
+      // Heads that have been resolved into local variables refer to
+      // whatever function has been given as an argument.
+      if (atom->is_interned() && !atom->address())
+      {
+        const auto it = form_map.find(atom->id());
+
+        if (it != std::end(form_map))
+        {
+          return it->second;
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  class compiler
+  {
+  public:
+    explicit compiler(program& program)
+      : m_program(program) {}
+
+    // Values in tail position of body of a `loop` form are compiled with
+    // `recur` set, so that `recur` found there can jump back to the start of
+    // the loop instead of unwinding the evaluation.
+    void compile(
+      const value::ptr& value,
+      bool tail = false,
+      bool recur = false
+    )
+    {
+      if (!value)
+      {
+        emit(opcode::push_nil);
+        return;
+      }
+
+      switch (value->type())
+      {
+        case value::type::atom:
+          // Immediate atoms never have lexical addresses, and only symbols
+          // among them are names of variables.
+          if (value.is_immediate())
+          {
+            emit(
+              value.is_symbol() ? opcode::eval : opcode::push_constant,
+              { constant(value) }
+            );
+          } else {
+            compile_atom(memory::static_pointer_cast<value::atom>(value));
+          }
+          break;
+
+        case value::type::list:
+          compile_list(
+            memory::static_pointer_cast<value::list>(value),
+            tail,
+            recur
+          );
+          break;
+
+        case value::type::function:
+        case value::type::array:
+        case value::type::vector:
+        case value::type::map:
+        case value::type::sequence:
+          emit(opcode::push_constant, { constant(value) });
+          break;
+      }
+    }
+
+  private:
+    using list_ptr = memory::ref<value::list>;
+
+    // Innermost `loop` form being compiled.
+    struct loop_context
+    {
+      // Position where each iteration of the loop starts.
+      std::size_t start;
+      // Index of the layout of the scope of the loop.
+      std::uint32_t layout;
+      // Number of scopes entered when the loop was entered.
+      std::size_t depth;
+      // Whether the body contains `recur` that could not be compiled into a
+      // jump, in which case the whole loop is left for the tree walking
+      // evaluator.
+      bool failed;
+    };
+
+    void compile_atom(const memory::ref<value::atom>& atom)
+    {
+      if (const auto& address = atom->address())
+      {
+        emit(opcode::load_local, { address->depth, address->index });
+      }
+      // Numeric literals are treated as constants instead of names of
+      // variables.
+      else if (!atom->is_interned() || utils::is_number(atom->symbol()))
+      {
+        emit(opcode::push_constant, { constant(atom) });
+      } else {
+        emit(opcode::eval, { constant(atom) });
+      }
+    }
+
+    void compile_list(const list_ptr& list, bool tail, bool recur)
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+
+      if (!size)
+      {
+        emit(opcode::push_constant, { constant(list) });
+        return;
+      }
+
+      if (const auto form = get_form(elements[0]))
+      {
+        bool compiled = false;
+
+        switch (*form)
+        {
+          case form::quote:
+            compiled = compile_quote(list);
+            break;
+
+          case form::if_:
+            compiled = compile_if(list, tail, recur);
+            break;
+
+          case form::and_:
+          case form::or_:
+            compile_logical(list, *form == form::and_);
+            compiled = true;
+            break;
+
+          case form::not_:
+            compiled = compile_not(list);
+            break;
+
+          case form::setq:
+            compiled = compile_setq(list);
+            break;
+
+          case form::let:
+            compiled = compile_let(list, tail, recur);
+            break;
+
+          case form::while_:
+            compiled = compile_while(list);
+            break;
+
+          case form::dotimes:
+            compiled = compile_dotimes(list);
+            break;
+
+          case form::loop:
+            compiled = compile_loop(list, tail);
+            break;
+
+          case form::recur:
+            compiled = compile_recur(list, recur);
+            break;
+
+          case form::add:
+            compiled = compile_arithmetic(list, opcode::add, 0);
+            break;
+
+          case form::subtract:
+            compiled = compile_arithmetic(list, opcode::subtract, 1);
+            break;
+
+          case form::multiply:
+            compiled = compile_arithmetic(list, opcode::multiply, 0);
+            break;
+
+          case form::divide:
+            compiled = compile_arithmetic(list, opcode::divide, 2);
+            break;
+
+          case form::eq:
+            compiled = compile_comparison(list, opcode::eq);
+            break;
+
+          case form::lt:
+            compiled = compile_comparison(list, opcode::lt);
+            break;
+
+          case form::gt:
+            compiled = compile_comparison(list, opcode::gt);
+            break;
+
+          case form::lte:
+            compiled = compile_comparison(list, opcode::lte);
+            break;
+
+          case form::gte:
+            compiled = compile_comparison(list, opcode::gte);
+            break;
+        }
+
+        // Malformed special forms are left for the tree walking evaluator,
+        // which reports the error.
+        if (!compiled)
+        {
+          if (m_loop && contains_recur(list))
+          {
+            m_loop->failed = true;
+          }
+          emit(opcode::eval, { constant(list) });
+        }
+
+        return;
+      }
+
+      compile_call(list, tail);
+    }
+
+    bool compile_quote(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+
+      if (elements.size() != 2)
+      {
+        return false;
+      }
+      emit(opcode::push_constant, { constant(elements[1]) });
+
+      return true;
+    }
+
+    bool compile_if(const list_ptr& list, bool tail, bool recur)
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+      std::size_t else_jump;
+      std::size_t end_jump;
+
+      if (size != 3 && size != 4)
+      {
+        return false;
+      }
+      compile(elements[1]);
+      else_jump = emit_jump(opcode::jump_if_false);
+      compile(elements[2], tail, recur);
+      end_jump = emit_jump(opcode::jump);
+      patch(else_jump);
+      if (size == 4)
+      {
+        compile(elements[3], tail, recur);
+      } else {
+        emit(opcode::push_nil);
+      }
+      patch(end_jump);
+
+      return true;
+    }
+
+    void compile_logical(const list_ptr& list, bool is_and)
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+      std::vector<std::size_t> jumps;
+      std::size_t end_jump;
+
+      for (value::list::size_type i = 1; i < size; ++i)
+      {
+        compile(elements[i]);
+        jumps.push_back(
+          emit_jump(is_and ? opcode::jump_if_false : opcode::jump_if_true)
+        );
+      }
+      if (is_and)
+      {
+        emit(opcode::push_constant, { constant(value::atom::make_bool(true)) });
+      } else {
+        emit(opcode::push_nil);
+      }
+      end_jump = emit_jump(opcode::jump);
+      for (const auto jump : jumps)
+      {
+        patch(jump);
+      }
+      if (is_and)
+      {
+        emit(opcode::push_nil);
+      } else {
+        emit(opcode::push_constant, { constant(value::atom::make_bool(true)) });
+      }
+      patch(end_jump);
+    }
+
+    bool compile_not(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+
+      if (elements.size() != 2)
+      {
+        return false;
+      }
+      compile(elements[1]);
+      emit(opcode::not_);
+
+      return true;
+    }
+
+    // Only assignments where the name of the variable is quoted atom are
+    // compiled, as those are the only ones known at compile time.
+    bool compile_setq(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+
+      if (elements.size() != 3)
+      {
+        return false;
+      }
+
+      const auto name = get_quoted_atom(elements[1]);
+
+      if (!name)
+      {
+        return false;
+      }
+      compile(elements[2]);
+      emit(opcode::set_dynamic, { name->id() });
+
+      return true;
+    }
+
+    // Compiles bindings of `let` style form and enters the scope where they
+    // are bound. Returns index of the layout of the scope, or nothing if the
+    // bindings are malformed, in which case no code is emitted.
+    std::optional<std::uint32_t> compile_bindings(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+      program::layout_type layout;
+
+      if (
+        elements.size() < 2 ||
+        !elements[1] ||
+        elements[1]->type() != value::type::list
+      )
+      {
+        return std::nullopt;
+      }
+
+      const auto& bindings = memory::static_pointer_cast<value::list>(
+        elements[1]
+      )->elements();
+
+      // Validate the bindings before emitting any code for them.
+      for (const auto& entry : bindings)
+      {
+        value::ptr name = entry;
+
+        if (entry && entry->type() == value::type::list)
+        {
+          const auto& pair = memory::static_pointer_cast<value::list>(
+            entry
+          )->elements();
+
+          if (pair.size() != 2)
+          {
+            return std::nullopt;
+          }
+          name = pair[0];
+        }
+        if (
+          !name ||
+          name->type() != value::type::atom ||
+          !memory::static_pointer_cast<value::atom>(name)->is_interned()
+        )
+        {
+          return std::nullopt;
+        }
+        layout.push_back(memory::static_pointer_cast<value::atom>(name)->id());
+      }
+
+      for (const auto& entry : bindings)
+      {
+        if (entry->type() == value::type::list)
+        {
+          compile(
+            memory::static_pointer_cast<value::list>(entry)->elements()[1]
+          );
+        } else {
+          emit(opcode::push_nil);
+        }
+      }
+
+      return enter_scope(layout);
+    }
+
+    std::uint32_t enter_scope(const program::layout_type& layout)
+    {
+      const auto index = static_cast<std::uint32_t>(
+        m_program.m_layouts.size()
+      );
+
+      m_program.m_layouts.push_back(layout);
+      emit(opcode::enter_scope, { index });
+      ++m_depth;
+
+      return index;
+    }
+
+    void leave_scope()
+    {
+      emit(opcode::leave_scope);
+      --m_depth;
+    }
+
+    // Compiles expressions of a body, leaving value of the last one in the
+    // stack.
+    void compile_body(
+      const list_ptr& list,
+      value::list::size_type begin,
+      bool tail,
+      bool recur
+    )
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+
+      if (size <= begin)
+      {
+        emit(opcode::push_nil);
+        return;
+      }
+      for (auto i = begin; i < size; ++i)
+      {
+        if (i > begin)
+        {
+          emit(opcode::pop);
+        }
+        compile(elements[i], tail && i + 1 == size, recur && i + 1 == size);
+      }
+    }
+
+    bool compile_let(const list_ptr& list, bool tail, bool recur)
+    {
+      if (!compile_bindings(list))
+      {
+        return false;
+      }
+      compile_body(list, 2, tail, recur);
+      leave_scope();
+
+      return true;
+    }
+
+    bool compile_while(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+      const auto start = m_program.m_code.size();
+      std::size_t end_jump;
+
+      if (elements.size() < 2)
+      {
+        return false;
+      }
+      compile(elements[1]);
+      end_jump = emit_jump(opcode::jump_if_false);
+      for (value::list::size_type i = 2; i < elements.size(); ++i)
+      {
+        compile(elements[i]);
+        emit(opcode::pop);
+      }
+      emit(opcode::jump, { static_cast<std::uint32_t>(start) });
+      patch(end_jump);
+      emit(opcode::push_nil);
+
+      return true;
+    }
+
+    // The count and the counter are kept unboxed in the number stack during
+    // the loop. The counter is boxed into the only slot of the scope of the
+    // loop once per iteration.
+    bool compile_dotimes(const list_ptr& list)
+    {
+      const auto& elements = list->elements();
+      std::size_t start;
+      std::size_t end_jump;
+
+      if (
+        elements.size() < 2 ||
+        !elements[1] ||
+        elements[1]->type() != value::type::list
+      )
+      {
+        return false;
+      }
+
+      const auto specification = memory::static_pointer_cast<value::list>(
+        elements[1]
+      );
+      const auto& pair = specification->elements();
+
+      if (
+        pair.size() != 2 ||
+        !pair[0] ||
+        pair[0]->type() != value::type::atom ||
+        !memory::static_pointer_cast<value::atom>(pair[0])->is_interned()
+      )
+      {
+        return false;
+      }
+
+      const auto name = memory::static_pointer_cast<value::atom>(
+        pair[0]
+      )->id();
+
+      compile_number(pair[1], constant(specification), 1);
+      m_program.m_numbers.push_back(0);
+      emit(
+        opcode::push_number,
+        { static_cast<std::uint32_t>(m_program.m_numbers.size() - 1) }
+      );
+      emit(opcode::push_nil);
+      enter_scope({ name });
+      start = m_program.m_code.size();
+      end_jump = emit_jump(opcode::iterate, { name });
+      for (value::list::size_type i = 2; i < elements.size(); ++i)
+      {
+        compile(elements[i]);
+        emit(opcode::pop);
+      }
+      emit(opcode::jump, { static_cast<std::uint32_t>(start) });
+      patch(end_jump);
+      leave_scope();
+      emit(opcode::push_nil);
+
+      return true;
+    }
+
+    bool compile_loop(const list_ptr& list, bool tail)
+    {
+      const auto code_start = m_program.m_code.size();
+      const auto previous = m_loop;
+      loop_context context;
+
+      if (const auto layout = compile_bindings(list))
+      {
+        context.layout = *layout;
+      } else {
+        return false;
+      }
+      context.start = m_program.m_code.size();
+      context.depth = m_depth;
+      context.failed = false;
+      m_loop = &context;
+      compile_body(list, 2, tail, true);
+      leave_scope();
+      m_loop = previous;
+      if (context.failed)
+      {
+        m_program.m_code.resize(code_start);
+        emit(opcode::eval, { constant(list) });
+      }
+
+      return true;
+    }
+
+    // Only `recur` in tail position of a loop is compiled, into rebinding
+    // of the variables of the loop followed by a jump to its start.
+    bool compile_recur(const list_ptr& list, bool recur)
+    {
+      const auto& elements = list->elements();
+
+      if (
+        !recur ||
+        !m_loop ||
+        elements.size() - 1 != m_program.m_layouts[m_loop->layout].size()
+      )
+      {
+        return false;
+      }
+      for (value::list::size_type i = 1; i < elements.size(); ++i)
+      {
+        compile(elements[i]);
+      }
+      for (auto depth = m_loop->depth; depth < m_depth; ++depth)
+      {
+        emit(opcode::leave_scope);
+      }
+      emit(opcode::rebind, { m_loop->layout });
+      emit(opcode::jump, { static_cast<std::uint32_t>(m_loop->start) });
+
+      return true;
+    }
+
+    // Tells whether the expression contains `recur` that would be
+    // evaluated as a part of it.
+    static bool contains_recur(const value::ptr& value)
+    {
+      if (!value || value->type() != value::type::list)
+      {
+        return false;
+      }
+
+      const auto& elements = memory::static_pointer_cast<value::list>(
+        value
+      )->elements();
+
+      if (elements.empty())
+      {
+        return false;
+      }
+
+      const auto head = get_form(elements[0]);
+
+      if (head == form::recur)
+      {
+        return true;
+      }
+      else if (head == form::quote)
+      {
+        return false;
+      }
+
+      return std::any_of(
+        std::begin(elements),
+        std::end(elements),
+        contains_recur
+      );
+    }
+
+    bool compile_arithmetic(
+      const list_ptr& list,
+      opcode op,
+      value::list::size_type minimum_arguments
+    )
+    {
+      if (!compile_arithmetic_number(list, op, minimum_arguments))
+      {
+        return false;
+      }
+      emit(opcode::box);
+
+      return true;
+    }
+
+    // Compiles arithmetic form so that it leaves its result unboxed in the
+    // number stack.
+    bool compile_arithmetic_number(
+      const list_ptr& list,
+      opcode op,
+      value::list::size_type minimum_arguments
+    )
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+      std::uint32_t form;
+
+      if (size - 1 < minimum_arguments)
+      {
+        return false;
+      }
+      form = constant(list);
+      for (value::list::size_type i = 1; i < size; ++i)
+      {
+        compile_number(elements[i], form, i);
+      }
+      emit(op, { static_cast<std::uint32_t>(size - 1) });
+
+      return true;
+    }
+
+    // Compiles operand of an arithmetic form or comparison into the number
+    // stack. Numeric literals and nested arithmetic are never boxed.
+    void compile_number(
+      const value::ptr& value,
+      std::uint32_t form,
+      value::list::size_type index
+    )
+    {
+      bali::number number;
+
+      if (value && value->type() == value::type::atom)
+      {
+        if (
+          (
+            value.is_immediate() ||
+            !memory::static_pointer_cast<value::atom>(value)->address()
+          ) &&
+          value.as_number(number)
+        )
+        {
+          m_program.m_numbers.push_back(number);
+          emit(
+            opcode::push_number,
+            { static_cast<std::uint32_t>(m_program.m_numbers.size() - 1) }
+          );
+          return;
+        }
+      }
+      else if (value && value->type() == value::type::list)
+      {
+        const auto list = memory::static_pointer_cast<value::list>(value);
+
+        if (!list->empty())
+        {
+          const auto head = get_form(list->elements()[0]);
+
+          if (
+            (head == form::add &&
+              compile_arithmetic_number(list, opcode::add, 0)) ||
+            (head == form::subtract &&
+              compile_arithmetic_number(list, opcode::subtract, 1)) ||
+            (head == form::multiply &&
+              compile_arithmetic_number(list, opcode::multiply, 0)) ||
+            (head == form::divide &&
+              compile_arithmetic_number(list, opcode::divide, 2))
+          )
+          {
+            return;
+          }
+        }
+      }
+      compile(value);
+      emit(opcode::unbox, { form, static_cast<std::uint32_t>(index) });
+    }
+
+    bool compile_comparison(const list_ptr& list, opcode op)
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+      const auto form = constant(list);
+      std::vector<std::size_t> jumps;
+      std::size_t end_jump;
+
+      if (size < 3)
+      {
+        return false;
+      }
+      compile_number(elements[1], form, 1);
+      for (value::list::size_type i = 2; i < size; ++i)
+      {
+        compile_number(elements[i], form, i);
+        jumps.push_back(emit_jump(op));
+      }
+      emit(opcode::pop_number);
+      emit(opcode::push_constant, { constant(value::atom::make_bool(true)) });
+      end_jump = emit_jump(opcode::jump);
+      for (const auto jump : jumps)
+      {
+        patch(jump);
+      }
+      emit(opcode::pop_number);
+      emit(opcode::push_nil);
+      patch(end_jump);
+
+      return true;
+    }
+
+    // Value of the head is called directly if it turns out to be a builtin
+    // function, as those receive their arguments unevaluated. Otherwise the
+    // arguments are evaluated and the function is called with them.
+    void compile_call(const list_ptr& list, bool tail)
+    {
+      const auto& elements = list->elements();
+      const auto size = elements.size();
+      std::size_t skip_position;
+
+      compile(elements[0]);
+      emit(opcode::call_builtin, { constant(list), 0 });
+      skip_position = m_program.m_code.size() - 1;
+      for (value::list::size_type i = 1; i < size; ++i)
+      {
+        compile(elements[i]);
+      }
+      emit(
+        tail ? opcode::tail_call : opcode::call,
+        { static_cast<std::uint32_t>(size - 1) }
+      );
+      m_program.m_code[skip_position] = static_cast<std::uint32_t>(
+        m_program.m_code.size() - skip_position - 1
+      );
+    }
+
+    static memory::ref<value::atom>
+    get_quoted_atom(const value::ptr& value)
+    {
+      if (!value || value->type() != value::type::list)
+      {
+        return nullptr;
+      }
+
+      const auto& elements = memory::static_pointer_cast<value::list>(
+        value
+      )->elements();
+
+      if (
+        elements.size() != 2 ||
+        get_form(elements[0]) != form::quote ||
+        !elements[1] ||
+        elements[1]->type() != value::type::atom
+      )
+      {
+        return nullptr;
+      }
+
+      return memory::static_pointer_cast<value::atom>(elements[1]);
+    }
+
+    std::uint32_t constant(const value::ptr& value)
+    {
+      m_program.m_constants.push_back(value);
+
+      return static_cast<std::uint32_t>(m_program.m_constants.size() - 1);
+    }
+
+    void emit(
+      opcode op,
+      std::initializer_list<std::uint32_t> operands = {}
+    )
+    {
+      m_program.m_code.push_back(static_cast<std::uint32_t>(op));
+      m_program.m_code.insert(
+        std::end(m_program.m_code),
+        std::begin(operands),
+        std::end(operands)
+      );
+    }
+
+    // Emits jump instruction where the target is the first operand, and
+    // returns position of the target so that it can be patched later.
+    std::size_t emit_jump(
+      opcode op,
+      std::initializer_list<std::uint32_t> operands = {}
+    )
+    {
+      std::size_t position;
+
+      m_program.m_code.push_back(static_cast<std::uint32_t>(op));
+      position = m_program.m_code.size();
+      m_program.m_code.push_back(0);
+      m_program.m_code.insert(
+        std::end(m_program.m_code),
+        std::begin(operands),
+        std::end(operands)
+      );
+
+      return position;
+    }
+
+    void patch(std::size_t position)
+    {
+      m_program.m_code[position] = static_cast<std::uint32_t>(
+        m_program.m_code.size()
+      );
+    }
+
+  private:
+    program& m_program;
+    loop_context* m_loop = nullptr;
+    // Number of scopes entered by the code being compiled.
+    std::size_t m_depth = 0;
+  };
+
+  program::program(const value::ptr& expression)
+  {
+    compiler(*this).compile(expression, true);
+  }
+}
@@ -29,7 +29,4 @@ namespace bali
 
     return os;
   }
-
-  function_return::function_return(const_reference value)
-    : m_value(value) {}
 }
@@ -1,87 +1,299 @@
-#include <peelo/unicode/encoding/utf8.hpp>
-
+#include <bali/bytecode.hpp>
 #include <bali/error.hpp>
 #include <bali/eval.hpp>
-#include <bali/utils.hpp>
 
 namespace bali
 {
   static value::ptr
-  eval_atom(
-    const std::shared_ptr<value::atom>& atom,
-    const std::shared_ptr<class scope>& scope
-  )
+  eval_atom(const value::ptr& value, const memory::ref<class scope>& scope)
   {
-    const auto id = atom->symbol();
     value::ptr variable;
 
-    if (scope->get(id, variable))
+    // Immediate numbers evaluate to themselves, and immediate symbols are
+    // never resolved into lexical addresses.
+    if (value.is_symbol())
+    {
+      if (scope->get(value.symbol(), variable))
+      {
+        return variable;
+      }
+
+      return value.symbol() == symbol::nil ? nullptr : value;
+    }
+    else if (value.is_immediate())
+    {
+      return value;
+    }
+
+    const auto atom = memory::static_pointer_cast<value::atom>(value);
+
+    if (const auto& address = atom->address())
+    {
+      return scope->at(*address);
+    }
+
+    // Atoms constructed from numbers during evaluation have no symbol
+    // identifier, so they cannot be names of variables either.
+    if (!atom->is_interned())
+    {
+      return atom;
+    }
+    else if (scope->get(atom->id(), variable))
     {
       return variable;
     }
 
-    return !id.compare(U"nil") ? nullptr : atom;
+    return atom->is_nil() ? nullptr : atom;
   }
 
-  static value::ptr
-  eval_list(
-    const std::shared_ptr<value::list>& list,
-    const std::shared_ptr<class scope>& scope
-  )
+  static bool returning = false;
+  static bool recurring = false;
+  static value::ptr return_value;
+  static value::list::container_type recur_values;
+
+  bool
+  is_returning()
+  {
+    return returning;
+  }
+
+  void
+  begin_return(const value::ptr& value)
+  {
+    returning = true;
+    return_value = value;
+  }
+
+  value::ptr
+  end_return()
   {
-    const auto& elements = list->elements();
-    const auto size = elements.size();
+    value::ptr result;
 
-    if (size > 0)
+    returning = false;
+    if (recurring)
     {
-      const auto function = to_function(elements[0], scope);
+      recurring = false;
+      recur_values.clear();
 
-      return function->call(
-        value::list::container_type(std::begin(elements) + 1, std::end(elements)),
-        scope
-      );
+      throw error(U"recur: Not inside `loop`.");
     }
+    std::swap(result, return_value);
+
+    return result;
+  }
+
+  bool
+  is_recurring()
+  {
+    return recurring;
+  }
+
+  void
+  begin_recur(value::list::container_type&& values)
+  {
+    returning = true;
+    recurring = true;
+    recur_values = std::move(values);
+  }
+
+  value::list::container_type
+  end_recur()
+  {
+    value::list::container_type result;
+
+    returning = false;
+    recurring = false;
+    std::swap(result, recur_values);
+
+    return result;
+  }
 
-    return list;
+  void
+  reset_return()
+  {
+    returning = false;
+    recurring = false;
+    return_value = nullptr;
+    recur_values.clear();
   }
 
   value::ptr
   eval(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
-    if (!value)
+    if (!value || returning)
     {
       return nullptr;
     }
+    else if (value->type() == value::type::atom)
+    {
+      return eval_atom(value, scope);
+    }
+    else if (value->type() != value::type::list)
+    {
+      return value;
+    }
+
+    auto current_value = value;
+    auto current_scope = scope;
+    // Scope from where the first custom function was called. Scopes created
+    // after it are used only by this loop, so custom functions called in
+    // tail position can drop the ones they shadow, which keeps tail
+    // recursion in constant space.
+    memory::ref<class scope> base_scope;
 
-    switch (value->type())
+    for (;;)
     {
-      case value::type::atom:
-        return eval_atom(std::static_pointer_cast<value::atom>(value), scope);
+      if (returning)
+      {
+        return base_scope ? end_return() : nullptr;
+      }
+      else if (!current_value)
+      {
+        return nullptr;
+      }
 
-      case value::type::list:
-        return eval_list(std::static_pointer_cast<value::list>(value), scope);
+      switch (current_value->type())
+      {
+        case value::type::atom:
+          return eval_atom(current_value, current_scope);
 
-      case value::type::function:
-        break;
-    }
+        case value::type::list:
+          break;
+
+        case value::type::function:
+        case value::type::array:
+        case value::type::vector:
+        case value::type::map:
+        case value::type::sequence:
+          return current_value;
+      }
+
+      const auto list = memory::static_pointer_cast<value::list>(current_value);
+      const auto& elements = list->elements();
+
+      if (elements.empty())
+      {
+        return list;
+      }
+
+      const auto function = to_function(elements[0], current_scope);
+      const auto begin = elements.data() + 1;
+      const auto end = elements.data() + elements.size();
+
+      if (returning)
+      {
+        continue;
+      }
 
-    return value;
+      // Builtin functions receive their arguments unevaluated, as some of
+      // them are special forms. Custom functions are called with values,
+      // which are evaluated directly into scope of the function.
+      if (const auto builtin = memory::dynamic_pointer_cast<
+        value::function::builtin
+      >(function))
+      {
+        value::function::builtin::tail_expression tail;
+        auto result = builtin->call(begin, end, current_scope, &tail);
+
+        if (!tail.scope)
+        {
+          if (returning)
+          {
+            continue;
+          }
+
+          return result;
+        }
+        current_value = std::move(tail.expression);
+        current_scope = std::move(tail.scope);
+        continue;
+      }
+
+      const auto custom = memory::static_pointer_cast<value::function::custom>(
+        function
+      );
+
+      if (bytecode::enabled)
+      {
+        const auto function_scope = custom->bind(
+          begin,
+          end,
+          current_scope,
+          current_scope
+        );
+
+        return custom->execute(function_scope, current_scope);
+      }
+
+      auto function_scope = custom->bind(
+        begin,
+        end,
+        current_scope,
+        current_scope
+      );
+
+      // `return` or `recur` in the arguments belongs to the caller, so the
+      // function is not entered.
+      if (returning)
+      {
+        continue;
+      }
+      else if (!base_scope)
+      {
+        base_scope = current_scope;
+      }
+      current_scope = std::move(function_scope);
+      current_scope->drop_shadowed(base_scope);
+      current_value = custom->expression();
+    }
   }
 
-  const std::u32string&
+  std::u32string
   to_atom(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     const auto result = scope ? eval(value, scope) : value;
 
     if (result && result->type() == value::type::atom)
     {
-      return std::static_pointer_cast<value::atom>(result)->symbol();
+      return memory::static_pointer_cast<value::atom>(result)->symbol();
+    }
+    else if (returning)
+    {
+      return std::u32string();
+    }
+
+    throw error(
+      U"Value is not an atom.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  symbol::id
+  to_symbol(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto result = scope ? eval(value, scope) : value;
+
+    if (result.is_symbol())
+    {
+      return result.symbol();
+    }
+    else if (result && result->type() == value::type::atom)
+    {
+      return memory::static_pointer_cast<value::atom>(result)->id();
+    }
+    else if (returning)
+    {
+      return symbol::nil;
     }
 
     throw error(
@@ -94,7 +306,7 @@ namespace bali
   bool
   to_bool(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     const auto result = scope ? eval(value, scope) : value;
@@ -103,35 +315,39 @@ namespace bali
     {
       return false;
     }
+    else if (result.is_immediate())
+    {
+      return !result.is_symbol() || result.symbol() != symbol::nil;
+    }
 
     switch (result->type())
     {
       case value::type::atom:
-        return std::static_pointer_cast<value::atom>(
-          result
-        )->symbol().compare(U"nil") != 0;
+        return !memory::static_pointer_cast<value::atom>(result)->is_nil();
 
       case value::type::list:
-        return std::static_pointer_cast<value::list>(
-          result
-        )->elements().size() > 0;
+        return !memory::static_pointer_cast<value::list>(result)->empty();
 
       default:
         return true;
     }
   }
 
-  std::shared_ptr<value::function>
+  memory::ref<value::function>
   to_function(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     const auto result = scope ? eval(value, scope) : value;
 
     if (result && result->type() == value::type::function)
     {
-      return std::static_pointer_cast<value::function>(result);
+      return memory::static_pointer_cast<value::function>(result);
+    }
+    else if (returning)
+    {
+      return nullptr;
     }
 
     throw error(
@@ -141,17 +357,23 @@ namespace bali
     );
   }
 
-  const value::list::container_type&
+  memory::ref<value::list>
   to_list(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     const auto result = scope ? eval(value, scope) : value;
 
     if (result && result->type() == value::type::list)
     {
-      return std::static_pointer_cast<value::list>(result)->elements();
+      return memory::static_pointer_cast<value::list>(result);
+    }
+    else if (returning)
+    {
+      static const auto empty = value::list::make({});
+
+      return empty;
     }
 
     throw error(
@@ -161,25 +383,141 @@ namespace bali
     );
   }
 
-  double
-  to_number(
+  memory::ref<value::array>
+  to_array(
     const value::ptr& value,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     const auto result = scope ? eval(value, scope) : value;
 
-    if (result && result->type() == value::type::atom)
+    if (result && result->type() == value::type::array)
+    {
+      return memory::static_pointer_cast<value::array>(result);
+    }
+    else if (returning)
+    {
+      static const auto empty = value::array::make(
+        value::array::integer_container_type()
+      );
+
+      return empty;
+    }
+
+    throw error(
+      U"Value is not an array.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  memory::ref<value::vector>
+  to_vector(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto result = scope ? eval(value, scope) : value;
+
+    if (result && result->type() == value::type::vector)
+    {
+      return memory::static_pointer_cast<value::vector>(result);
+    }
+    else if (returning)
+    {
+      static const auto empty = value::vector::make(nullptr, nullptr);
+
+      return empty;
+    }
+
+    throw error(
+      U"Value is not a vector.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  memory::ref<value::map>
+  to_map(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto result = scope ? eval(value, scope) : value;
+
+    if (result && result->type() == value::type::map)
+    {
+      return memory::static_pointer_cast<value::map>(result);
+    }
+    else if (returning)
     {
-      const auto& symbol = std::static_pointer_cast<value::atom>(
-        result
-      )->symbol();
+      static const auto empty = value::map::make();
+
+      return empty;
+    }
 
-      if (utils::is_number(symbol))
+    throw error(
+      U"Value is not a map.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  memory::ref<value::sequence>
+  to_sequence(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto result = scope ? eval(value, scope) : value;
+
+    if (result)
+    {
+      switch (result->type())
       {
-        return std::stod(peelo::unicode::encoding::utf8::encode(symbol));
+        case value::type::sequence:
+          return memory::static_pointer_cast<value::sequence>(result);
+
+        case value::type::list:
+        case value::type::vector:
+          return value::sequence::make_elements(result);
+
+        default:
+          break;
       }
     }
+    if (returning)
+    {
+      static const auto empty = value::sequence::make_elements(nullptr);
+
+      return empty;
+    }
+
+    throw error(
+      U"Value is not a sequence.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  number
+  to_number(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto result = scope ? eval(value, scope) : value;
+
+    number number;
+
+    if (result.as_number(number))
+    {
+      return number;
+    }
+    else if (returning)
+    {
+      return 0;
+    }
 
     throw error(
       U"Value is not a number.",
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 
@@ -6,6 +7,9 @@
 #include <bali/error.hpp>
 #include <bali/eval.hpp>
 #include <bali/parser.hpp>
+#include <bali/port.hpp>
+#include <bali/printer.hpp>
+#include <bali/simd.hpp>
 
 namespace bali
 {
@@ -15,9 +19,11 @@ namespace bali
   >;
   using custom_function_map_type = std::unordered_map<
     std::u32string,
-    std::shared_ptr<value::function>
+    memory::ref<value::function>
   >;
-  using compare_callback_type = bool(*)(double, double);
+  using compare_callback_type = bool(*)(const number&, const number&);
+  using tail_expression = value::function::builtin::tail_expression;
+  using array_ptr = memory::ref<value::array>;
 
   static inline value::ptr
   eat(
@@ -57,12 +63,33 @@ namespace bali
     }
   }
 
+  // Evaluates value that is the result of builtin function, or leaves it for
+  // the caller to evaluate if the builtin function was called in tail
+  // position.
+  static inline value::ptr
+  eval_tail(
+    const value::ptr& value,
+    const memory::ref<class scope>& scope,
+    tail_expression* tail
+  )
+  {
+    if (tail)
+    {
+      tail->expression = value;
+      tail->scope = scope;
+
+      return nullptr;
+    }
+
+    return eval(value, scope);
+  }
+
   static inline value::ptr
   compare(
     compare_callback_type callback,
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
     if (it != end)
@@ -85,10 +112,11 @@ namespace bali
   function_add(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    double result = 0;
+    number result = 0;
 
     while (it != end)
     {
@@ -102,7 +130,8 @@ namespace bali
   function_substract(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     auto result = to_number(eat("-", it, end), scope);
@@ -125,10 +154,11 @@ namespace bali
   function_multiply(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    double result = 1;
+    number result = 1;
 
     while (it != end)
     {
@@ -142,7 +172,8 @@ namespace bali
   function_divide(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     auto result = to_number(eat("/", it, end), scope);
@@ -155,7 +186,11 @@ namespace bali
     {
       const auto divider = to_number(*it++, scope);
 
-      if (divider == 0)
+      if (is_returning())
+      {
+        return nullptr;
+      }
+      else if (divider.is_zero())
       {
         throw error(U"/: Division by zero.");
       }
@@ -170,11 +205,12 @@ namespace bali
   function_eq(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     return compare(
-      [](double a, double b)
+      [](const number& a, const number& b)
       {
         return a == b;
       },
@@ -188,11 +224,12 @@ namespace bali
   function_lt(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     return compare(
-      [](double a, double b)
+      [](const number& a, const number& b)
       {
         return a < b;
       },
@@ -206,11 +243,12 @@ namespace bali
   function_gt(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     return compare(
-      [](double a, double b)
+      [](const number& a, const number& b)
       {
         return a > b;
       },
@@ -224,11 +262,12 @@ namespace bali
   function_lte(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     return compare(
-      [](double a, double b)
+      [](const number& a, const number& b)
       {
         return a <= b;
       },
@@ -242,11 +281,12 @@ namespace bali
   function_gte(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     return compare(
-      [](double a, double b)
+      [](const number& a, const number& b)
       {
         return a >= b;
       },
@@ -260,48 +300,53 @@ namespace bali
   function_length(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     const auto list = to_list(eat("length", it, end), scope);
 
     finish("length", it, end);
 
-    return value::atom::make_number(list.size());
+    return value::atom::make_number(
+      static_cast<number::integer_type>(list->size())
+    );
   }
 
   static value::ptr
   function_cons(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     const auto head = eval(eat("cons", it, end), scope);
     const auto tail = to_list(eat("cons", it, end), scope);
-    value::list::container_type result;
 
     finish("cons", it, end);
-    result.reserve(tail.size() + 1);
-    result.push_back(head);
-    result.insert(std::end(result), std::begin(tail), std::end(tail));
 
-    return value::list::make(result);
+    return tail->prepend(&head, &head + 1);
   }
 
   static value::ptr
   function_car(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     const auto list = to_list(eat("car", it, end), scope);
 
     finish("car", it, end);
-    if (list.size() > 0)
+    if (!list->empty())
+    {
+      return list->elements()[0];
+    }
+    else if (is_returning())
     {
-      return list[0];
+      return nullptr;
     }
 
     throw error(U"car: Empty list.");
@@ -311,20 +356,20 @@ namespace bali
   function_cdr(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     const auto list = to_list(eat("cdr", it, end), scope);
 
     finish("cdr", it, end);
-    if (list.size() > 0)
+    if (!list->empty())
     {
-      return value::list::make(
-        value::list::container_type(
-          std::begin(list) + 1,
-          std::end(list)
-        )
-      );
+      return list->rest();
+    }
+    else if (is_returning())
+    {
+      return nullptr;
     }
 
     throw error(U"cdr: Empty list.");
@@ -334,7 +379,8 @@ namespace bali
   function_list(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
     value::list::container_type result;
@@ -344,42 +390,75 @@ namespace bali
       result.push_back(eval(*it++, scope));
     }
 
-    return value::list::make(result);
+    return value::list::make(std::move(result));
   }
 
   static value::ptr
   function_append(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    value::list::container_type result;
+    std::vector<memory::ref<value::list>> lists;
+    memory::ref<value::list> result;
 
     while (it != end)
     {
-      const auto list = to_list(*it++, scope);
+      lists.push_back(to_list(*it++, scope));
+    }
+    if (lists.empty())
+    {
+      return value::list::make({});
+    }
+
+    // Elements of the last list are shared with the result, so only the
+    // preceding lists need to be copied.
+    result = lists.back();
+    for (auto i = lists.size() - 1; i > 0; --i)
+    {
+      const auto elements = lists[i - 1]->elements();
 
-      result.insert(std::end(result), std::begin(list), std::end(list));
+      result = result->prepend(std::begin(elements), std::end(elements));
     }
 
-    return value::list::make(result);
+    return result;
   }
 
   static value::ptr
   function_for_each(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto list = to_list(eat("for-each", it, end), scope);
+    const auto collection = eval(eat("for-each", it, end), scope);
     const auto callback = to_function(eat("for-each", it, end), scope);
 
     finish("for-each", it, end);
-    for (const auto& element : list)
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (collection && collection->type() == value::type::sequence)
+    {
+      const auto cursor = memory::static_pointer_cast<value::sequence>(
+        collection
+      )->iterate();
+      value::ptr element;
+
+      while (cursor->next(element, scope) && !is_returning())
+      {
+        callback->call(&element, &element + 1, scope);
+      }
+
+      return nullptr;
+    }
+    for (const auto& element : to_list(collection, nullptr)->elements())
     {
-      callback->call({ element }, scope);
+      callback->call(&element, &element + 1, scope);
     }
 
     return nullptr;
@@ -389,326 +468,1735 @@ namespace bali
   function_filter(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto list = to_list(eat("filter", it, end), scope);
+    const auto collection = eval(eat("filter", it, end), scope);
     const auto callback = to_function(eat("filter", it, end), scope);
     value::list::container_type result;
 
     finish("filter", it, end);
-    for (const auto& element : list)
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    // Filtering a lazy sequence produces another lazy sequence.
+    else if (collection && collection->type() == value::type::sequence)
+    {
+      return memory::static_pointer_cast<value::sequence>(
+        collection
+      )->filter(callback);
+    }
+    for (const auto& element : to_list(collection, nullptr)->elements())
     {
-      if (to_bool(callback->call({ element }, scope), nullptr))
+      if (to_bool(callback->call(&element, &element + 1, scope), nullptr))
       {
         result.push_back(element);
       }
     }
 
-    return value::list::make(result);
+    return value::list::make(std::move(result));
   }
 
   static value::ptr
   function_map(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto list = to_list(eat("map", it, end), scope);
+    const auto collection = eval(eat("map", it, end), scope);
     const auto callback = to_function(eat("map", it, end), scope);
     value::list::container_type result;
+    memory::ref<value::list> list;
 
-    finish("filter", it, end);
-    result.reserve(list.size());
-    for (const auto& element : list)
+    finish("map", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (collection && collection->type() == value::type::sequence)
     {
-      result.push_back(callback->call({ element }, scope));
+      return memory::static_pointer_cast<value::sequence>(
+        collection
+      )->map(callback);
+    }
+    list = to_list(collection, nullptr);
+    result.reserve(list->size());
+    for (const auto& element : list->elements())
+    {
+      result.push_back(callback->call(&element, &element + 1, scope));
     }
 
-    return value::list::make(result);
+    return value::list::make(std::move(result));
   }
 
-  static value::ptr
-  function_not(
+  static inline error
+  function_error(const char* function, const std::u32string& message)
+  {
+    return error(
+      peelo::unicode::encoding::utf8::decode(
+        function,
+        std::strlen(function)
+      ) + U": " + message
+    );
+  }
+
+  // Returns the elements of the array as floating point numbers. Elements
+  // of integer arrays are converted into given storage.
+  static const number::real_type*
+  reals_of(
+    const array_ptr& array,
+    value::array::real_container_type& storage
+  )
+  {
+    if (!array->is_integer())
+    {
+      return array->reals().data();
+    }
+
+    const auto& integers = array->integers();
+
+    storage.assign(std::begin(integers), std::end(integers));
+
+    return storage.data();
+  }
+
+  // Converts value into an index that is at most given limit.
+  static std::size_t
+  to_index(
+    const char* function,
+    const value::ptr& value,
+    const memory::ref<class scope>& scope,
+    std::size_t limit
+  )
+  {
+    const auto index = to_number(value, scope);
+
+    if (is_returning())
+    {
+      return 0;
+    }
+    else if (
+      !index.is_integer() ||
+      index.integer() < 0 ||
+      static_cast<std::uint64_t>(index.integer()) > limit
+    )
+    {
+      throw function_error(function, U"Index out of bounds.");
+    }
+
+    return static_cast<std::size_t>(index.integer());
+  }
+
+  static std::pair<array_ptr, array_ptr>
+  eat_array_pair(
+    const char* function,
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
-    const auto condition = to_bool(eat("not", it, end), scope);
+    const auto a = to_array(eat(function, it, end), scope);
+    const auto b = to_array(eat(function, it, end), scope);
 
-    finish("not", it, end);
+    finish(function, it, end);
+    if (a->size() != b->size() && !is_returning())
+    {
+      throw function_error(function, U"Arrays have different lengths.");
+    }
 
-    return value::atom::make_bool(!condition);
+    return { a, b };
   }
 
   static value::ptr
-  function_and(
+  apply_arrays(
+    const char* function,
+    simd::operation op,
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
-    while (it != end)
+    const auto [a, b] = eat_array_pair(function, it, end, scope);
+    const auto size = a->size();
+    value::array::real_container_type a_storage;
+    value::array::real_container_type b_storage;
+    value::array::real_container_type result(size);
+    const number::real_type* b_reals;
+
+    if (is_returning())
     {
-      if (!to_bool(*it++, scope))
+      return nullptr;
+    }
+    if (a->is_integer() && b->is_integer())
+    {
+      const auto& divider = b->integers();
+      value::array::integer_container_type integers(size);
+
+      if (
+        op == simd::operation::divide &&
+        std::find(std::begin(divider), std::end(divider), 0) !=
+          std::end(divider)
+      )
       {
-        return value::atom::make_bool(false);
+        throw function_error(function, U"Division by zero.");
       }
+      // Results that overflow or leave a remainder turn the whole array
+      // into floating point numbers.
+      if (simd::apply(
+        op,
+        a->integers().data(),
+        divider.data(),
+        integers.data(),
+        size
+      ))
+      {
+        return value::array::make(std::move(integers));
+      }
+    }
+    b_reals = reals_of(b, b_storage);
+    if (
+      op == simd::operation::divide &&
+      std::find(b_reals, b_reals + size, 0.0) != b_reals + size
+    )
+    {
+      throw function_error(function, U"Division by zero.");
     }
+    simd::apply(op, reals_of(a, a_storage), b_reals, result.data(), size);
 
-    return value::atom::make_bool(true);
+    return value::array::make(std::move(result));
   }
 
   static value::ptr
-  function_or(
+  compare_arrays(
+    const char* function,
+    simd::comparison op,
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope
   )
   {
-    while (it != end)
+    const auto [a, b] = eat_array_pair(function, it, end, scope);
+    const auto size = a->size();
+    value::array::integer_container_type result(size);
+
+    if (is_returning())
     {
-      if (to_bool(*it++, scope))
-      {
-        return value::atom::make_bool(true);
-      }
+      return nullptr;
+    }
+    else if (a->is_integer() && b->is_integer())
+    {
+      simd::compare(
+        op,
+        a->integers().data(),
+        b->integers().data(),
+        result.data(),
+        size
+      );
+    } else {
+      value::array::real_container_type a_storage;
+      value::array::real_container_type b_storage;
+
+      simd::compare(
+        op,
+        reals_of(a, a_storage),
+        reals_of(b, b_storage),
+        result.data(),
+        size
+      );
     }
 
-    return value::atom::make_bool(false);
+    return value::array::make(std::move(result));
   }
 
   static value::ptr
-  function_if(
+  function_make_array(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto condition = eat("if", it, end);
-    const auto then_value = eat("if", it, end);
-    value::ptr else_value;
+    const auto list = to_list(eat("make-array", it, end), scope);
+    const auto elements = list->elements();
+    value::array::integer_container_type integers;
+    value::array::real_container_type reals;
+    bool is_integer = true;
+
+    finish("make-array", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    integers.reserve(elements.size());
+    for (const auto& element : elements)
+    {
+      const auto number = to_number(element, nullptr);
 
-    if (it != end)
+      if (is_integer && number.is_integer())
+      {
+        integers.push_back(number.integer());
+        continue;
+      }
+      else if (is_integer)
+      {
+        is_integer = false;
+        reals.reserve(elements.size());
+        reals.assign(std::begin(integers), std::end(integers));
+      }
+      reals.push_back(number.real());
+    }
+
+    if (is_integer)
     {
-      else_value = *it++;
+      return value::array::make(std::move(integers));
     }
-    finish("if", it, end);
 
-    return eval(to_bool(condition, scope) ? then_value : else_value, scope);
+    return value::array::make(std::move(reals));
   }
 
   static value::ptr
-  function_setq(
+  function_array_length(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto name = to_atom(eat("setq", it, end), scope);
-    const auto value = eval(eat("setq", it, end), scope);
+    const auto array = to_array(eat("array-length", it, end), scope);
 
-    finish("setq", it, end);
-    scope->set(name, value);
+    finish("array-length", it, end);
 
-    return value;
+    return value::atom::make_number(
+      static_cast<number::integer_type>(array->size())
+    );
   }
 
   static value::ptr
-  function_let(
+  function_array_ref(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto variable_list = to_list(eat("let", it, end), nullptr);
-    auto new_scope = std::make_shared<class scope>(scope);
-    value::ptr return_value;
+    const auto array = to_array(eat("array-ref", it, end), scope);
+    const auto size = array->size();
+    const auto index = to_index(
+      "array-ref",
+      eat("array-ref", it, end),
+      scope,
+      size
+    );
 
-    for (const auto& entry : variable_list)
+    finish("array-ref", it, end);
+    if (is_returning())
     {
-      if (entry && entry->type() == value::type::list)
-      {
-        const auto& pair = std::static_pointer_cast<value::list>(
-          entry
-        )->elements();
-
-        if (pair.size() != 2)
-        {
-          throw error(
-            U"Malformed `let` binding.",
-            entry->line(),
-            entry->column()
-          );
-        }
-        new_scope->let(to_atom(pair[0], nullptr), eval(pair[1], scope));
-      } else {
-        new_scope->let(to_atom(entry, nullptr), nullptr);
-      }
+      return nullptr;
     }
-    while (it != end)
+    else if (index == size)
     {
-      return_value = eval(*it++, new_scope);
+      throw error(U"array-ref: Index out of bounds.");
     }
 
-    return return_value;
+    return value::atom::make_number(array->at(index));
   }
 
   static value::ptr
-  function_quote(
+  function_array_slice(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>&
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto result = eat("quote", it, end);
+    const auto array = to_array(eat("array-slice", it, end), scope);
+    const auto size = array->size();
+    const auto begin = to_index(
+      "array-slice",
+      eat("array-slice", it, end),
+      scope,
+      size
+    );
+    const auto stop = it != end
+      ? to_index("array-slice", *it++, scope, size)
+      : size;
 
-    finish("quote", it, end);
+    finish("array-slice", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (begin > stop)
+    {
+      throw error(U"array-slice: Index out of bounds.");
+    }
 
-    return result;
+    return array->slice(begin, stop);
   }
 
   static value::ptr
-  function_apply(
+  function_array_to_list(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto function = to_function(eat("apply", it, end), scope);
-    const auto args = to_list(eat("apply", it, end), scope);
+    const auto array = to_array(eat("array->list", it, end), scope);
+    const auto size = array->size();
+    value::list::container_type result;
 
-    finish("apply", it, end);
+    finish("array->list", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    result.reserve(size);
+    for (value::array::size_type i = 0; i < size; ++i)
+    {
+      result.push_back(value::atom::make_number(array->at(i)));
+    }
 
-    return function->call(args, scope);
+    return value::list::make(std::move(result));
   }
 
   static value::ptr
-  function_defun(
+  function_array_sum(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto name = to_atom(eat("defun", it, end), scope);
-    const auto raw_parameters = to_list(eat("defun", it, end), nullptr);
-    std::vector<std::u32string> parameters;
-    const auto expression = eat("defun", it, end);
-    std::shared_ptr<value::function> function;
+    const auto array = to_array(eat("array-sum", it, end), scope);
 
-    finish("defun", it, end);
-    parameters.reserve(raw_parameters.size());
-    for (const auto& parameter : raw_parameters)
+    finish("array-sum", it, end);
+    if (is_returning())
     {
-      parameters.push_back(to_atom(parameter, nullptr));
+      return nullptr;
     }
-    function = value::function::custom::make(parameters, expression, name);
-    scope->set(name, function);
+    else if (array->is_integer())
+    {
+      const auto& integers = array->integers();
+      number::integer_type result;
+      number sum = 0;
 
-    return function;
+      if (simd::sum(integers.data(), integers.size(), result))
+      {
+        return value::atom::make_number(result);
+      }
+      // Sum does not fit into 64 bits, so it's computed again as bignum.
+      for (const auto integer : integers)
+      {
+        sum += integer;
+      }
+
+      return value::atom::make_number(sum);
+    }
+
+    return value::atom::make_number(
+      simd::sum(array->reals().data(), array->size())
+    );
   }
 
   static value::ptr
-  function_return_(
+  function_array_dot(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    value::ptr return_value;
+    const auto [a, b] = eat_array_pair("array-dot", it, end, scope);
+    const auto size = a->size();
 
-    if (it != end)
+    if (is_returning())
     {
-      return_value = eval(*it++, scope);
+      return nullptr;
     }
-    finish("return", it, end);
+    else if (a->is_integer() && b->is_integer())
+    {
+      const auto& x = a->integers();
+      const auto& y = b->integers();
+      number::integer_type result;
+      number dot = 0;
+
+      if (simd::dot(x.data(), y.data(), size, result))
+      {
+        return value::atom::make_number(result);
+      }
+      for (value::array::size_type i = 0; i < size; ++i)
+      {
+        number product = x[i];
+
+        product *= y[i];
+        dot += product;
+      }
 
-    throw function_return(return_value);
+      return value::atom::make_number(dot);
+    }
+
+    value::array::real_container_type a_storage;
+    value::array::real_container_type b_storage;
+
+    return value::atom::make_number(simd::dot(
+      reals_of(a, a_storage),
+      reals_of(b, b_storage),
+      size
+    ));
   }
 
   static value::ptr
-  function_lambda(
+  function_array_min(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<scope>&
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto raw_parameters = to_list(eat("lambda", it, end), nullptr);
-    std::vector<std::u32string> parameters;
-    const auto expression = eat("lambda", it, end);
+    const auto array = to_array(eat("array-min", it, end), scope);
 
-    finish("lambda", it, end);
-    parameters.reserve(raw_parameters.size());
-    for (const auto& parameter : raw_parameters)
+    finish("array-min", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (!array->size())
+    {
+      throw error(U"array-min: Empty array.");
+    }
+    else if (array->is_integer())
     {
-      parameters.push_back(to_atom(parameter, nullptr));
+      return value::atom::make_number(
+        simd::min(array->integers().data(), array->size())
+      );
     }
 
-    return value::function::custom::make(parameters, expression);
+    return value::atom::make_number(
+      simd::min(array->reals().data(), array->size())
+    );
   }
 
   static value::ptr
-  function_load(
+  function_array_max(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto filename = to_atom(eat("load", it, end), scope);
-    const auto encoded_filename = peelo::unicode::encoding::utf8::encode(
-      filename
-    );
+    const auto array = to_array(eat("array-max", it, end), scope);
 
-    finish("load", it, end);
-    if (auto file = std::ifstream(encoded_filename))
+    finish("array-max", it, end);
+    if (is_returning())
     {
-      const auto source = std::string(
-        std::istreambuf_iterator<char>(file),
-        std::istreambuf_iterator<char>()
+      return nullptr;
+    }
+    else if (!array->size())
+    {
+      throw error(U"array-max: Empty array.");
+    }
+    else if (array->is_integer())
+    {
+      return value::atom::make_number(
+        simd::max(array->integers().data(), array->size())
       );
-
-      file.close();
-      for (const auto& value : parse(source, 1, 1, false))
-      {
-        eval(value, scope);
-      }
-    } else {
-      throw error(U"Unable to open file `" + filename + U"'.");
     }
 
-    return nullptr;
+    return value::atom::make_number(
+      simd::max(array->reals().data(), array->size())
+    );
   }
 
   static value::ptr
-  function_write(
+  function_array_add(
     value::list::iterator& it,
     const value::list::iterator& end,
-    const std::shared_ptr<class scope>& scope
+    const memory::ref<class scope>& scope,
+    tail_expression*
   )
   {
-    const auto result = eat("write", it, end);
-
-    finish("write", it, end);
-    std::cout << eval(result, scope) << std::endl;
-
-    return nullptr;
+    return apply_arrays(
+      "array+",
+      simd::operation::add,
+      it,
+      end,
+      scope
+    );
   }
 
-  static const builtin_function_map_type builtin_function_map =
+  static value::ptr
+  function_array_substract(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
   {
-    // Arithmetic functions.
-    { U"+", function_add },
-    { U"-", function_substract },
-    { U"*", function_multiply },
-    { U"/", function_divide },
-
-    // Comparison functions.
-    { U"=", function_eq },
-    { U"<", function_lt },
-    { U">", function_gt },
-    { U"<=", function_lte },
-    { U">=", function_gte },
+    return apply_arrays(
+      "array-",
+      simd::operation::subtract,
+      it,
+      end,
+      scope
+    );
+  }
+
+  static value::ptr
+  function_array_multiply(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    return apply_arrays(
+      "array*",
+      simd::operation::multiply,
+      it,
+      end,
+      scope
+    );
+  }
+
+  static value::ptr
+  function_array_divide(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    return apply_arrays(
+      "array/",
+      simd::operation::divide,
+      it,
+      end,
+      scope
+    );
+  }
+
+  static value::ptr
+  function_array_eq(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    return compare_arrays(
+      "array=",
+      simd::comparison::equal,
+      it,
+      end,
+      scope
+    );
+  }
+
+  static value::ptr
+  function_array_lt(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    return compare_arrays(
+      "array<",
+      simd::comparison::less,
+      it,
+      end,
+      scope
+    );
+  }
+
+  static value::ptr
+  function_array_gt(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    return compare_arrays(
+      "array>",
+      simd::comparison::greater,
+      it,
+      end,
+      scope
+    );
+  }
+
+  // Evaluates value that must be either a list or a vector.
+  static value::ptr
+  to_collection(const value::ptr& value, const memory::ref<class scope>& scope)
+  {
+    const auto result = eval(value, scope);
+
+    if (
+      result &&
+      (
+        result->type() == value::type::list ||
+        result->type() == value::type::vector
+      )
+    )
+    {
+      return result;
+    }
+    else if (is_returning())
+    {
+      return nullptr;
+    }
+
+    throw error(
+      U"Value is not a list or a vector.",
+      value ? value->line() : std::nullopt,
+      value ? value->column() : std::nullopt
+    );
+  }
+
+  static inline std::size_t
+  collection_size(const value::ptr& collection)
+  {
+    if (!collection)
+    {
+      return 0;
+    }
+    else if (collection->type() == value::type::vector)
+    {
+      return memory::static_pointer_cast<value::vector>(collection)->size();
+    }
+
+    return memory::static_pointer_cast<value::list>(collection)->size();
+  }
+
+  static value::ptr
+  function_vector(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    value::list::container_type elements;
+
+    while (it != end)
+    {
+      elements.push_back(eval(*it++, scope));
+    }
+
+    return value::vector::make(
+      elements.data(),
+      elements.data() + elements.size()
+    );
+  }
+
+  static value::ptr
+  function_list_to_vector(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto list = to_list(eat("list->vector", it, end), scope);
+    const auto elements = list->elements();
+
+    finish("list->vector", it, end);
+
+    return value::vector::make(std::begin(elements), std::end(elements));
+  }
+
+  static value::ptr
+  function_vector_to_list(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto vector = to_vector(eat("vector->list", it, end), scope);
+    const auto size = vector->size();
+    value::list::container_type result;
+
+    finish("vector->list", it, end);
+    result.reserve(size);
+    for (value::vector::size_type i = 0; i < size; ++i)
+    {
+      result.push_back(vector->at(i));
+    }
+
+    return value::list::make(std::move(result));
+  }
+
+  static value::ptr
+  function_vector_length(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto vector = to_vector(eat("vector-length", it, end), scope);
+
+    finish("vector-length", it, end);
+
+    return value::atom::make_number(
+      static_cast<number::integer_type>(vector->size())
+    );
+  }
+
+  static value::ptr
+  function_nth(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto collection = to_collection(eat("nth", it, end), scope);
+    const auto size = collection_size(collection);
+    const auto index = to_index("nth", eat("nth", it, end), scope, size);
+
+    finish("nth", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (index == size)
+    {
+      throw error(U"nth: Index out of bounds.");
+    }
+    else if (collection->type() == value::type::vector)
+    {
+      return memory::static_pointer_cast<value::vector>(collection)->at(index);
+    }
+
+    return memory::static_pointer_cast<value::list>(
+      collection
+    )->elements()[index];
+  }
+
+  static value::ptr
+  function_set_nth(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto collection = to_collection(eat("set-nth", it, end), scope);
+    const auto size = collection_size(collection);
+    const auto index = to_index(
+      "set-nth",
+      eat("set-nth", it, end),
+      scope,
+      size
+    );
+    const auto value = eval(eat("set-nth", it, end), scope);
+
+    finish("set-nth", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (index == size)
+    {
+      throw error(U"set-nth: Index out of bounds.");
+    }
+    else if (collection->type() == value::type::vector)
+    {
+      return memory::static_pointer_cast<value::vector>(
+        collection
+      )->set(index, value);
+    }
+
+    const auto elements = memory::static_pointer_cast<value::list>(
+      collection
+    )->elements();
+    value::list::container_type result(
+      std::begin(elements),
+      std::end(elements)
+    );
+
+    result[index] = value;
+
+    return value::list::make(std::move(result));
+  }
+
+  static value::ptr
+  function_subseq(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto collection = to_collection(eat("subseq", it, end), scope);
+    const auto size = collection_size(collection);
+    const auto begin = to_index("subseq", eat("subseq", it, end), scope, size);
+    const auto stop = it != end
+      ? to_index("subseq", *it++, scope, size)
+      : size;
+
+    finish("subseq", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (begin > stop)
+    {
+      throw error(U"subseq: Index out of bounds.");
+    }
+    else if (collection->type() == value::type::vector)
+    {
+      return memory::static_pointer_cast<value::vector>(
+        collection
+      )->slice(begin, stop);
+    }
+
+    const auto elements = memory::static_pointer_cast<value::list>(
+      collection
+    )->elements();
+
+    return value::list::make(value::list::container_type(
+      std::begin(elements) + begin,
+      std::begin(elements) + stop
+    ));
+  }
+
+  static value::ptr
+  function_make_map(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    auto result = value::map::make();
+
+    while (it != end)
+    {
+      const auto key = eval(*it++, scope);
+      const auto value = eval(eat("make-map", it, end), scope);
+
+      result = result->assoc(key, value);
+    }
+
+    return is_returning() ? nullptr : result;
+  }
+
+  static value::ptr
+  function_get(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto map = to_map(eat("get", it, end), scope);
+    const auto key = eval(eat("get", it, end), scope);
+    const auto fallback = it != end ? *it++ : nullptr;
+
+    finish("get", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (const auto value = map->find(key))
+    {
+      return *value;
+    }
+
+    return eval(fallback, scope);
+  }
+
+  static value::ptr
+  function_assoc(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    auto result = to_map(eat("assoc", it, end), scope);
+
+    do
+    {
+      const auto key = eval(eat("assoc", it, end), scope);
+      const auto value = eval(eat("assoc", it, end), scope);
+
+      result = result->assoc(key, value);
+    }
+    while (it != end);
+
+    return is_returning() ? nullptr : result;
+  }
+
+  static value::ptr
+  function_dissoc(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    auto result = to_map(eat("dissoc", it, end), scope);
+
+    while (it != end)
+    {
+      result = result->dissoc(eval(*it++, scope));
+    }
+
+    return is_returning() ? nullptr : result;
+  }
+
+  static value::ptr
+  function_keys(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto map = to_map(eat("keys", it, end), scope);
+    value::list::container_type result;
+
+    finish("keys", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    result.reserve(map->size());
+    map->for_each([&](const value::ptr& key, const value::ptr&)
+    {
+      result.push_back(key);
+    });
+
+    return value::list::make(std::move(result));
+  }
+
+  static value::ptr
+  function_map_size(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto map = to_map(eat("map-size", it, end), scope);
+
+    finish("map-size", it, end);
+
+    return value::atom::make_number(
+      static_cast<number::integer_type>(map->size())
+    );
+  }
+
+  static value::ptr
+  function_range(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    number start = 0;
+    std::optional<number> stop;
+    number step = 1;
+
+    if (it != end)
+    {
+      stop = to_number(*it++, scope);
+      if (it != end)
+      {
+        start = *stop;
+        stop = to_number(*it++, scope);
+        if (it != end)
+        {
+          step = to_number(*it++, scope);
+        }
+      }
+    }
+    finish("range", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (step.is_zero())
+    {
+      throw error(U"range: Step must not be zero.");
+    }
+
+    return value::sequence::make_range(start, stop, step);
+  }
+
+  static value::ptr
+  function_seq(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto sequence = to_sequence(eat("seq", it, end), scope);
+
+    finish("seq", it, end);
+
+    return is_returning() ? nullptr : sequence;
+  }
+
+  static value::ptr
+  function_take(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto sequence = to_sequence(eat("take", it, end), scope);
+    const auto count = to_number(eat("take", it, end), scope);
+
+    finish("take", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (!count.is_integer() || count.integer() < 0)
+    {
+      throw error(U"take: Count must be a non-negative integer.");
+    }
+
+    return sequence->take(
+      static_cast<value::sequence::size_type>(count.integer())
+    );
+  }
+
+  static value::ptr
+  function_take_while(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto sequence = to_sequence(eat("take-while", it, end), scope);
+    const auto callback = to_function(eat("take-while", it, end), scope);
+
+    finish("take-while", it, end);
+
+    return is_returning() ? nullptr : sequence->take_while(callback);
+  }
+
+  static value::ptr
+  function_reduce(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto sequence = to_sequence(eat("reduce", it, end), scope);
+    const auto callback = to_function(eat("reduce", it, end), scope);
+    value::ptr arguments[2];
+
+    arguments[0] = eval(eat("reduce", it, end), scope);
+    finish("reduce", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+
+    const auto cursor = sequence->iterate();
+
+    // Accumulator and the element are passed in the same array, so that the
+    // callback can be called without allocating the arguments.
+    while (cursor->next(arguments[1], scope) && !is_returning())
+    {
+      arguments[0] = callback->call(arguments, arguments + 2, scope);
+    }
+
+    return is_returning() ? nullptr : arguments[0];
+  }
+
+  static value::ptr
+  function_sequence_to_list(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto sequence = to_sequence(eat("sequence->list", it, end), scope);
+    value::list::container_type result;
+    value::ptr element;
+
+    finish("sequence->list", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+
+    const auto cursor = sequence->iterate();
+
+    while (cursor->next(element, scope) && !is_returning())
+    {
+      result.push_back(element);
+    }
+
+    return is_returning()
+      ? nullptr
+      : value::list::make(std::move(result));
+  }
+
+  static value::ptr
+  function_not(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto condition = to_bool(eat("not", it, end), scope);
+
+    finish("not", it, end);
+
+    return value::atom::make_bool(!condition);
+  }
+
+  static value::ptr
+  function_and(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    while (it != end)
+    {
+      if (!to_bool(*it++, scope))
+      {
+        return value::atom::make_bool(false);
+      }
+    }
+
+    return value::atom::make_bool(true);
+  }
+
+  static value::ptr
+  function_or(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    while (it != end)
+    {
+      if (to_bool(*it++, scope))
+      {
+        return value::atom::make_bool(true);
+      }
+    }
+
+    return value::atom::make_bool(false);
+  }
+
+  static value::ptr
+  function_if(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression* tail
+  )
+  {
+    const auto condition = eat("if", it, end);
+    const auto then_value = eat("if", it, end);
+    value::ptr else_value;
+
+    if (it != end)
+    {
+      else_value = *it++;
+    }
+    finish("if", it, end);
+
+    return eval_tail(
+      to_bool(condition, scope) ? then_value : else_value,
+      scope,
+      tail
+    );
+  }
+
+  static value::ptr
+  function_setq(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto name = to_symbol(eat("setq", it, end), scope);
+    const auto value = eval(eat("setq", it, end), scope);
+
+    finish("setq", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    scope->set(name, value);
+
+    return value;
+  }
+
+  // Binds variables of `let` style binding list into the new scope. Initial
+  // values of the variables are evaluated in the enclosing scope. Names of
+  // the variables are returned in the order they were bound.
+  static std::vector<symbol::id>
+  bind_variables(
+    const char* function,
+    const value::ptr& bindings,
+    const memory::ref<class scope>& scope,
+    const memory::ref<class scope>& new_scope
+  )
+  {
+    const auto variable_list = to_list(bindings, nullptr);
+    std::vector<symbol::id> names;
+
+    names.reserve(variable_list->size());
+    for (const auto& entry : variable_list->elements())
+    {
+      if (entry && entry->type() == value::type::list)
+      {
+        const auto pair = memory::static_pointer_cast<value::list>(
+          entry
+        )->elements();
+
+        if (pair.size() != 2)
+        {
+          throw error(
+            U"Malformed `" + peelo::unicode::encoding::utf8::decode(
+              function,
+              std::strlen(function)
+            ) + U"` binding.",
+            entry->line(),
+            entry->column()
+          );
+        }
+        names.push_back(to_symbol(pair[0], nullptr));
+        new_scope->let(names.back(), eval(pair[1], scope));
+      } else {
+        names.push_back(to_symbol(entry, nullptr));
+        new_scope->let(names.back(), nullptr);
+      }
+    }
+
+    return names;
+  }
+
+  static value::ptr
+  function_let(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression* tail
+  )
+  {
+    auto new_scope = memory::make<class scope>(scope);
+
+    bind_variables("let", eat("let", it, end), scope, new_scope);
+    while (it != end)
+    {
+      const auto& expression = *it++;
+
+      if (it == end)
+      {
+        return eval_tail(expression, new_scope, tail);
+      }
+      eval(expression, new_scope);
+    }
+
+    return nullptr;
+  }
+
+  // Evaluates body of a loop once. Returns false if the evaluation is being
+  // unwound by `return` or `recur`.
+  static inline bool
+  eval_body(
+    const value::list::iterator& begin,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    value::ptr* result = nullptr
+  )
+  {
+    for (auto it = begin; it != end; ++it)
+    {
+      auto value = eval(*it, scope);
+
+      if (is_returning())
+      {
+        return false;
+      }
+      else if (result)
+      {
+        *result = std::move(value);
+      }
+    }
+
+    return true;
+  }
+
+  static value::ptr
+  function_while(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto condition = eat("while", it, end);
+    const auto body = it;
+
+    it = end;
+    while (to_bool(condition, scope))
+    {
+      if (!eval_body(body, end, scope))
+      {
+        break;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // The counter lives in a single scope that is created once for the whole
+  // loop, and is updated in place on each iteration.
+  static value::ptr
+  function_dotimes(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto specification = to_list(eat("dotimes", it, end), nullptr);
+    const auto body = it;
+    memory::ref<class scope> new_scope;
+    symbol::id name;
+    number count;
+
+    it = end;
+    if (specification->size() != 2)
+    {
+      throw error(
+        U"Malformed `dotimes` specification.",
+        specification->line(),
+        specification->column()
+      );
+    }
+    name = to_symbol(specification->elements()[0], nullptr);
+    count = to_number(specification->elements()[1], scope);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    new_scope = memory::make<class scope>(scope, 1);
+    for (number index = 0; index < count; index += 1)
+    {
+      new_scope->let(name, value::atom::make_number(index));
+      if (!eval_body(body, end, new_scope))
+      {
+        break;
+      }
+    }
+
+    return nullptr;
+  }
+
+  static value::ptr
+  function_loop(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    auto new_scope = memory::make<class scope>(scope);
+    const auto names = bind_variables(
+      "loop",
+      eat("loop", it, end),
+      scope,
+      new_scope
+    );
+    const auto body = it;
+    value::ptr result;
+
+    it = end;
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    while (!eval_body(body, end, new_scope, &result))
+    {
+      if (!is_recurring())
+      {
+        return nullptr;
+      }
+
+      const auto values = end_recur();
+
+      if (values.size() < names.size())
+      {
+        throw error(U"recur: Not enough arguments.");
+      }
+      else if (values.size() > names.size())
+      {
+        throw error(U"recur: Too many arguments.");
+      }
+      for (std::size_t i = 0; i < names.size(); ++i)
+      {
+        new_scope->let(names[i], values[i]);
+      }
+    }
+
+    return result;
+  }
+
+  static value::ptr
+  function_recur(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    value::list::container_type values;
+
+    while (it != end)
+    {
+      values.push_back(eval(*it++, scope));
+      if (is_returning())
+      {
+        return nullptr;
+      }
+    }
+    begin_recur(std::move(values));
+
+    return nullptr;
+  }
+
+  static value::ptr
+  function_quote(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>&,
+    tail_expression*
+  )
+  {
+    const auto result = eat("quote", it, end);
+
+    finish("quote", it, end);
+
+    return result;
+  }
+
+  static value::ptr
+  function_apply(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto function = to_function(eat("apply", it, end), scope);
+    const auto args = to_list(eat("apply", it, end), scope);
+
+    finish("apply", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+
+    const auto elements = args->elements();
+
+    return function->call(std::begin(elements), std::end(elements), scope);
+  }
+
+  static value::ptr
+  function_defun(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto name = to_symbol(eat("defun", it, end), scope);
+    const auto raw_parameters = to_list(eat("defun", it, end), nullptr);
+    std::vector<symbol::id> parameters;
+    const auto expression = eat("defun", it, end);
+    memory::ref<value::function> function;
+
+    finish("defun", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    parameters.reserve(raw_parameters->size());
+    for (const auto& parameter : raw_parameters->elements())
+    {
+      parameters.push_back(to_symbol(parameter, nullptr));
+    }
+    function = value::function::custom::make(
+      parameters,
+      expression,
+      symbol::name(name)
+    );
+    scope->set(name, function);
+
+    return function;
+  }
+
+  static value::ptr
+  function_return_(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<scope>& scope,
+    tail_expression*
+  )
+  {
+    value::ptr return_value;
+
+    if (it != end)
+    {
+      return_value = eval(*it++, scope);
+    }
+    finish("return", it, end);
+    if (!is_returning())
+    {
+      begin_return(return_value);
+    }
+
+    return nullptr;
+  }
+
+  static value::ptr
+  function_lambda(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<scope>&,
+    tail_expression*
+  )
+  {
+    const auto raw_parameters = to_list(eat("lambda", it, end), nullptr);
+    std::vector<symbol::id> parameters;
+    const auto expression = eat("lambda", it, end);
+
+    finish("lambda", it, end);
+    parameters.reserve(raw_parameters->size());
+    for (const auto& parameter : raw_parameters->elements())
+    {
+      parameters.push_back(to_symbol(parameter, nullptr));
+    }
+
+    return value::function::custom::make(parameters, expression);
+  }
+
+  static value::ptr
+  function_load(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto filename = to_atom(eat("load", it, end), scope);
+    const auto encoded_filename = peelo::unicode::encoding::utf8::encode(
+      filename
+    );
+
+    finish("load", it, end);
+    if (is_returning())
+    {
+      return nullptr;
+    }
+    else if (auto file = std::ifstream(encoded_filename))
+    {
+      const auto source = std::string(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()
+      );
+
+      file.close();
+      for (const auto& value : parse(source, 1, 1, false))
+      {
+        eval(value, scope);
+        if (is_returning())
+        {
+          break;
+        }
+      }
+    } else {
+      throw error(U"Unable to open file `" + filename + U"'.");
+    }
+
+    return nullptr;
+  }
+
+  static value::ptr
+  function_write(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression*
+  )
+  {
+    const auto expression = eat("write", it, end);
+    value::ptr result;
+
+    finish("write", it, end);
+    result = eval(expression, scope);
+    if (!is_returning())
+    {
+      auto& output = port::current();
+
+      print(output, result);
+      output.end_line();
+    }
+
+    return nullptr;
+  }
+
+  static value::ptr
+  function_flush(
+    value::list::iterator& it,
+    const value::list::iterator& end,
+    const memory::ref<class scope>&,
+    tail_expression*
+  )
+  {
+    finish("flush", it, end);
+    port::current().flush();
+
+    return nullptr;
+  }
+
+  static const builtin_function_map_type builtin_function_map =
+  {
+    // Arithmetic functions.
+    { U"+", function_add },
+    { U"-", function_substract },
+    { U"*", function_multiply },
+    { U"/", function_divide },
+
+    // Comparison functions.
+    { U"=", function_eq },
+    { U"<", function_lt },
+    { U">", function_gt },
+    { U"<=", function_lte },
+    { U">=", function_gte },
 
     // List functions.
     { U"length", function_length },
@@ -721,12 +2209,61 @@ namespace bali
     { U"filter", function_filter },
     { U"map", function_map },
 
+    // Array functions.
+    { U"make-array", function_make_array },
+    { U"array-length", function_array_length },
+    { U"array-ref", function_array_ref },
+    { U"array-slice", function_array_slice },
+    { U"array->list", function_array_to_list },
+    { U"array-sum", function_array_sum },
+    { U"array-dot", function_array_dot },
+    { U"array-min", function_array_min },
+    { U"array-max", function_array_max },
+    { U"array+", function_array_add },
+    { U"array-", function_array_substract },
+    { U"array*", function_array_multiply },
+    { U"array/", function_array_divide },
+    { U"array=", function_array_eq },
+    { U"array<", function_array_lt },
+    { U"array>", function_array_gt },
+
+    // Vector functions.
+    { U"vector", function_vector },
+    { U"list->vector", function_list_to_vector },
+    { U"vector->list", function_vector_to_list },
+    { U"vector-length", function_vector_length },
+    { U"nth", function_nth },
+    { U"set-nth", function_set_nth },
+    { U"subseq", function_subseq },
+
+    // Map functions.
+    { U"make-map", function_make_map },
+    { U"get", function_get },
+    { U"assoc", function_assoc },
+    { U"dissoc", function_dissoc },
+    { U"keys", function_keys },
+    { U"map-size", function_map_size },
+
+    // Sequence functions.
+    { U"range", function_range },
+    { U"seq", function_seq },
+    { U"take", function_take },
+    { U"take-while", function_take_while },
+    { U"reduce", function_reduce },
+    { U"sequence->list", function_sequence_to_list },
+
     // Conditions.
     { U"not", function_not },
     { U"and", function_and },
     { U"or", function_or },
     { U"if", function_if },
 
+    // Loops.
+    { U"while", function_while },
+    { U"dotimes", function_dotimes },
+    { U"loop", function_loop },
+    { U"recur", function_recur },
+
     // Variables.
     { U"setq", function_setq },
     { U"let", function_let },
@@ -741,21 +2278,21 @@ namespace bali
     { U"quote", function_quote },
     { U"load", function_load },
     { U"write", function_write },
+    { U"flush", function_flush },
   };
 
-  std::shared_ptr<scope>
+  memory::ref<scope>
   scope::make_top_level()
   {
     auto scope = new class scope();
 
     for (const auto& entry : builtin_function_map)
     {
-      scope->m_variables[entry.first] = value::function::builtin::make(
-        entry.second,
-        entry.first
-      );
+      scope->m_variables[
+        symbol::intern(entry.first)
+      ] = value::function::builtin::make(entry.second, entry.first);
     }
 
-    return std::shared_ptr<class scope>(scope);
+    return memory::ref<class scope>(scope);
   }
 }
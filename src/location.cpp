@@ -0,0 +1,109 @@
+#include <vector>
+
+#include <bali/location.hpp>
+
+namespace bali::location
+{
+  namespace
+  {
+    // Missing line or column number is stored as this.
+    const int missing = -1;
+
+    struct entry
+    {
+      int line;
+      int column;
+      std::uint32_t references;
+    };
+
+    struct table
+    {
+      // First entry is reserved for values that have no location.
+      std::vector<entry> entries = { entry{ missing, missing, 0 } };
+      // Entries that are no longer referenced by any value.
+      std::vector<id> unused;
+    };
+  }
+
+  // The table is never freed, so that values in static variables can still
+  // release their locations when they are destroyed.
+  static inline table&
+  get_table()
+  {
+    static const auto instance = new table();
+
+    return *instance;
+  }
+
+  static inline entry&
+  get_entry(id location)
+  {
+    return get_table().entries[static_cast<std::uint32_t>(location)];
+  }
+
+  static inline std::optional<int>
+  to_optional(int number)
+  {
+    return number == missing ? std::nullopt : std::make_optional(number);
+  }
+
+  id
+  make(const std::optional<int>& line, const std::optional<int>& column)
+  {
+    auto& table = get_table();
+    const entry new_entry = {
+      line.value_or(missing),
+      column.value_or(missing),
+      1
+    };
+    id location;
+
+    if (!line && !column)
+    {
+      return id::none;
+    }
+    else if (!table.unused.empty())
+    {
+      location = table.unused.back();
+      table.unused.pop_back();
+      get_entry(location) = new_entry;
+    } else {
+      location = static_cast<id>(table.entries.size());
+      table.entries.push_back(new_entry);
+    }
+
+    return location;
+  }
+
+  id
+  retain(id location)
+  {
+    if (location != id::none)
+    {
+      ++get_entry(location).references;
+    }
+
+    return location;
+  }
+
+  void
+  release(id location)
+  {
+    if (location != id::none && !--get_entry(location).references)
+    {
+      get_table().unused.push_back(location);
+    }
+  }
+
+  std::optional<int>
+  line(id location)
+  {
+    return to_optional(get_entry(location).line);
+  }
+
+  std::optional<int>
+  column(id location)
+  {
+    return to_optional(get_entry(location).column);
+  }
+}
@@ -425,8 +425,7 @@ AGAIN:
             expression,
             callback(pos, end)
           },
-          expression->line(),
-          expression->column()
+          *expression
         );
         goto AGAIN;
       }
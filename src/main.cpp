@@ -10,13 +10,31 @@
 
 #include <peelo/prompt.hpp>
 
+#include <bali/bytecode.hpp>
 #include <bali/error.hpp>
 #include <bali/eval.hpp>
 #include <bali/parser.hpp>
+#include <bali/port.hpp>
+#include <bali/printer.hpp>
+#include <bali/resolver.hpp>
 
 static std::string programfile;
 static bool use_mexpression = false;
 
+static bali::value::ptr
+evaluate(
+  const bali::value::ptr& value,
+  const bali::memory::ref<bali::scope>& scope
+)
+{
+  if (bali::bytecode::enabled)
+  {
+    return bali::bytecode::program(bali::resolve({}, value)).execute(scope);
+  }
+
+  return bali::eval(value, scope);
+}
+
 static void
 count_open_parenthesis(const std::string& input, int& count)
 {
@@ -38,8 +56,9 @@ count_open_parenthesis(const std::string& input, int& count)
 }
 
 static void
-repl(const std::shared_ptr<bali::scope>& scope)
+repl(const bali::memory::ref<bali::scope>& scope)
 {
+  auto& output = bali::port::standard();
   peelo::prompt prompt;
   std::string script;
   int line_counter = 0;
@@ -68,18 +87,27 @@ repl(const std::shared_ptr<bali::scope>& scope)
           use_mexpression
         ))
         {
-          std::cout << bali::eval(value, scope) << std::endl;
+          const auto result = evaluate(value, scope);
+
+          if (bali::is_returning())
+          {
+            bali::end_return();
+            output.stream() << "Unexpected `return'.";
+            output.end_line();
+            break;
+          }
+          bali::print(output, result);
+          output.end_line();
         }
       }
       catch (bali::error& e)
       {
-        std::cout << e << std::endl;
-      }
-      catch (bali::function_return&)
-      {
-        std::cout << "Unexpected `return'." << std::endl;
+        bali::reset_return();
+        output.stream() << e;
+        output.end_line();
       }
       script.clear();
+      output.flush();
     }
   }
 }
@@ -87,7 +115,7 @@ repl(const std::shared_ptr<bali::scope>& scope)
 static void
 run_file(
   std::istream& file,
-  const std::shared_ptr<bali::scope>& scope
+  const bali::memory::ref<bali::scope>& scope
 )
 {
   const auto source = std::string(
@@ -99,19 +127,24 @@ run_file(
   {
     for (const auto& value : bali::parse(source, 1, 1, use_mexpression))
     {
-      bali::eval(value, scope);
+      evaluate(value, scope);
+      if (bali::is_returning())
+      {
+        bali::end_return();
+        bali::port::current().flush();
+        std::cerr << "Unexpected `return'." << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
     }
   }
   catch (bali::error& e)
   {
+    // Output written before the error is flushed first, so that it comes
+    // before the error message when both are written into the same file.
+    bali::port::current().flush();
     std::cerr << e << std::endl;
     std::exit(EXIT_FAILURE);
   }
-  catch (bali::function_return&)
-  {
-    std::cerr << "Unexpected `return'." << std::endl;
-    std::exit(EXIT_FAILURE);
-  }
 }
 
 static void
@@ -123,8 +156,12 @@ print_usage(std::ostream& output, const char* executable_name)
     << executable_name
     << " [switches] [programfile]"
     << std::endl
+    << "  -b                Compile functions into bytecode."
+    << std::endl
     << "  -m                Use M-expressions."
     << std::endl
+    << "  -o file           Write output into given file."
+    << std::endl
     << "  --version         Print the version."
     << std::endl
     << "  --help            Display this message."
@@ -175,10 +212,33 @@ parse_args(int argc, char** argv)
     {
       switch (arg[i])
       {
+        case 'b':
+          bali::bytecode::enabled = true;
+          break;
+
         case 'm':
           use_mexpression = true;
           break;
 
+        case 'o':
+          if (offset >= argc)
+          {
+            std::cerr << "Argument expected for the -o switch." << std::endl;
+            std::exit(EXIT_FAILURE);
+          }
+          else if (!bali::port::redirect(argv[offset]))
+          {
+            std::cerr
+              << argv[0]
+              << ": Unable to open file `"
+              << argv[offset]
+              << "'"
+              << std::endl;
+            std::exit(EXIT_FAILURE);
+          }
+          ++offset;
+          break;
+
         case 'h':
           print_usage(std::cout, argv[0]);
           std::exit(EXIT_SUCCESS);
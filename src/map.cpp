@@ -0,0 +1,519 @@
+#include <cmath>
+#include <functional>
+
+#include <bali/value.hpp>
+
+namespace bali
+{
+  using hash_type = value::map::hash_type;
+
+  static constexpr unsigned bits = 5;
+  static constexpr unsigned hash_bits = sizeof(hash_type) * 8;
+
+  static inline unsigned
+  fragment(hash_type hash, unsigned shift)
+  {
+    return static_cast<unsigned>(hash >> shift) & ((1 << bits) - 1);
+  }
+
+  // Returns position of the bit among the set bits of the bitmap.
+  static inline std::size_t
+  position(std::uint32_t bitmap, std::uint32_t bit)
+  {
+    std::size_t result = 0;
+
+    for (bitmap &= bit - 1; bitmap; bitmap &= bitmap - 1)
+    {
+      ++result;
+    }
+
+    return result;
+  }
+
+  // Finalizer of SplitMix64, which spreads the bits of integers whose hashes
+  // would otherwise only differ in their lowest bits.
+  static inline hash_type
+  mix(std::uint64_t value)
+  {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+
+    return static_cast<hash_type>(value ^ (value >> 31));
+  }
+
+  static inline hash_type
+  combine(hash_type seed, hash_type hash)
+  {
+    return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+
+  // Returns symbol identifier of an atom that is not a number.
+  static inline symbol::id
+  symbol_of(const value::ptr& atom)
+  {
+    if (atom.is_symbol())
+    {
+      return atom.symbol();
+    }
+
+    return memory::static_pointer_cast<value::atom>(atom)->id();
+  }
+
+  // Numbers that are equal have equal hashes, regardless of whether they are
+  // stored as integers, bignums or floating point numbers.
+  static hash_type
+  hash_number(const number& number)
+  {
+    if (number.is_integer())
+    {
+      return mix(static_cast<std::uint64_t>(number.integer()));
+    }
+
+    const auto real = number.real();
+
+    if (
+      !number.is_bignum() &&
+      std::trunc(real) == real &&
+      real >= -9223372036854775808.0 &&
+      real < 9223372036854775808.0
+    )
+    {
+      return mix(static_cast<std::uint64_t>(
+        static_cast<number::integer_type>(real)
+      ));
+    }
+
+    return mix(std::hash<number::real_type>()(real));
+  }
+
+  hash_type
+  value::map::hash(const value_type& key)
+  {
+    hash_type result;
+
+    if (!key)
+    {
+      return 0;
+    }
+
+    switch (key->type())
+    {
+      case value::type::atom:
+        {
+          bali::number number;
+
+          if (key.as_number(number))
+          {
+            return hash_number(number);
+          }
+
+          return mix(symbol_of(key));
+        }
+
+      case value::type::list:
+        result = 1;
+        for (const auto& element :
+             memory::static_pointer_cast<value::list>(key)->elements())
+        {
+          result = combine(result, hash(element));
+        }
+        return result;
+
+      case value::type::vector:
+        {
+          const auto vector = memory::static_pointer_cast<value::vector>(key);
+          const auto size = vector->size();
+
+          result = 2;
+          for (value::vector::size_type i = 0; i < size; ++i)
+          {
+            result = combine(result, hash(vector->at(i)));
+          }
+        }
+        return result;
+
+      default:
+        return mix(reinterpret_cast<std::uintptr_t>(key.get()));
+    }
+  }
+
+  bool
+  value::map::equals(const value_type& a, const value_type& b)
+  {
+    if (a == b)
+    {
+      return true;
+    }
+    else if (!a || !b || a->type() != b->type())
+    {
+      return false;
+    }
+
+    switch (a->type())
+    {
+      case value::type::atom:
+        {
+          bali::number x_number;
+          bali::number y_number;
+          const auto x_is_number = a.as_number(x_number);
+          const auto y_is_number = b.as_number(y_number);
+
+          if (x_is_number || y_is_number)
+          {
+            return x_is_number && y_is_number && x_number == y_number;
+          }
+
+          return symbol_of(a) == symbol_of(b);
+        }
+
+      case value::type::list:
+        {
+          const auto x = memory::static_pointer_cast<value::list>(a);
+          const auto y = memory::static_pointer_cast<value::list>(b);
+          const auto size = x->size();
+
+          if (size != y->size())
+          {
+            return false;
+          }
+          for (value::list::size_type i = 0; i < size; ++i)
+          {
+            if (!equals(x->elements()[i], y->elements()[i]))
+            {
+              return false;
+            }
+          }
+
+          return true;
+        }
+
+      case value::type::vector:
+        {
+          const auto x = memory::static_pointer_cast<value::vector>(a);
+          const auto y = memory::static_pointer_cast<value::vector>(b);
+          const auto size = x->size();
+
+          if (size != y->size())
+          {
+            return false;
+          }
+          for (value::vector::size_type i = 0; i < size; ++i)
+          {
+            if (!equals(x->at(i), y->at(i)))
+            {
+              return false;
+            }
+          }
+
+          return true;
+        }
+
+      default:
+        return false;
+    }
+  }
+
+  value::map::map(
+    const memory::ref<node>& root,
+    size_type size,
+    const std::optional<int>& line,
+    const std::optional<int>& column
+  )
+    : value::value(line, column)
+    , m_root(root)
+    , m_size(size) {}
+
+  memory::ref<value::map>
+  value::map::make(
+    const std::optional<int>& line,
+    const std::optional<int>& column
+  )
+  {
+    return memory::ref<map>(new map(nullptr, 0, line, column));
+  }
+
+  const value::map::value_type*
+  value::map::find(const value_type& key) const
+  {
+    const auto hash = map::hash(key);
+    auto current = m_root.get();
+
+    for (unsigned shift = 0; current; shift += bits)
+    {
+      if (shift >= hash_bits)
+      {
+        for (const auto& entry : current->entries)
+        {
+          if (equals(entry.first, key))
+          {
+            return &entry.second;
+          }
+        }
+
+        return nullptr;
+      }
+
+      const std::uint32_t bit = 1u << fragment(hash, shift);
+
+      if (current->entry_map & bit)
+      {
+        const auto& entry = current->entries[
+          position(current->entry_map, bit)
+        ];
+
+        return equals(entry.first, key) ? &entry.second : nullptr;
+      }
+      else if (!(current->child_map & bit))
+      {
+        return nullptr;
+      }
+      current = current->children[position(current->child_map, bit)].get();
+    }
+
+    return nullptr;
+  }
+
+  // Returns node that contains both entries, which have different keys.
+  memory::ref<value::map::node>
+  value::map::merge(
+    const entry& a,
+    hash_type a_hash,
+    const entry& b,
+    hash_type b_hash,
+    unsigned shift
+  )
+  {
+    const auto result = memory::make<node>();
+
+    if (shift >= hash_bits)
+    {
+      result->entries = { a, b };
+
+      return result;
+    }
+
+    const auto a_fragment = fragment(a_hash, shift);
+    const auto b_fragment = fragment(b_hash, shift);
+
+    if (a_fragment == b_fragment)
+    {
+      result->child_map = 1u << a_fragment;
+      result->children.push_back(
+        merge(a, a_hash, b, b_hash, shift + bits)
+      );
+    } else {
+      result->entry_map = (1u << a_fragment) | (1u << b_fragment);
+      if (a_fragment < b_fragment)
+      {
+        result->entries = { a, b };
+      } else {
+        result->entries = { b, a };
+      }
+    }
+
+    return result;
+  }
+
+  memory::ref<value::map::node>
+  value::map::assoc(
+    const memory::ref<node>& node,
+    unsigned shift,
+    hash_type hash,
+    const entry& entry,
+    bool& added
+  )
+  {
+    const auto result = node
+      ? memory::make<map::node>(*node)
+      : memory::make<map::node>();
+
+    if (shift >= hash_bits)
+    {
+      for (auto& existing : result->entries)
+      {
+        if (equals(existing.first, entry.first))
+        {
+          existing.second = entry.second;
+
+          return result;
+        }
+      }
+      result->entries.push_back(entry);
+      added = true;
+
+      return result;
+    }
+
+    const std::uint32_t bit = 1u << fragment(hash, shift);
+
+    if (result->entry_map & bit)
+    {
+      const auto index = position(result->entry_map, bit);
+      const auto existing = result->entries[index];
+
+      if (equals(existing.first, entry.first))
+      {
+        result->entries[index].second = entry.second;
+
+        return result;
+      }
+      // Two different keys share the same bits on this level, so they are
+      // moved into a child node.
+      result->entries.erase(std::begin(result->entries) + index);
+      result->entry_map &= ~bit;
+      result->children.insert(
+        std::begin(result->children) + position(result->child_map, bit),
+        merge(
+          existing,
+          map::hash(existing.first),
+          entry,
+          hash,
+          shift + bits
+        )
+      );
+      result->child_map |= bit;
+      added = true;
+    }
+    else if (result->child_map & bit)
+    {
+      auto& child = result->children[position(result->child_map, bit)];
+
+      child = assoc(child, shift + bits, hash, entry, added);
+    } else {
+      result->entries.insert(
+        std::begin(result->entries) + position(result->entry_map, bit),
+        entry
+      );
+      result->entry_map |= bit;
+      added = true;
+    }
+
+    return result;
+  }
+
+  memory::ref<value::map::node>
+  value::map::dissoc(
+    const memory::ref<node>& node,
+    unsigned shift,
+    hash_type hash,
+    const value_type& key,
+    bool& removed
+  )
+  {
+    if (shift >= hash_bits)
+    {
+      const auto size = node->entries.size();
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        if (equals(node->entries[i].first, key))
+        {
+          const auto result = memory::make<map::node>(*node);
+
+          result->entries.erase(std::begin(result->entries) + i);
+          removed = true;
+
+          return result->entries.empty() ? nullptr : result;
+        }
+      }
+
+      return node;
+    }
+
+    const std::uint32_t bit = 1u << fragment(hash, shift);
+
+    if (node->entry_map & bit)
+    {
+      const auto index = position(node->entry_map, bit);
+
+      if (!equals(node->entries[index].first, key))
+      {
+        return node;
+      }
+
+      const auto result = memory::make<map::node>(*node);
+
+      result->entries.erase(std::begin(result->entries) + index);
+      result->entry_map &= ~bit;
+      removed = true;
+
+      return result->entries.empty() && result->children.empty()
+        ? nullptr
+        : result;
+    }
+    else if (node->child_map & bit)
+    {
+      const auto index = position(node->child_map, bit);
+      const auto child = dissoc(
+        node->children[index],
+        shift + bits,
+        hash,
+        key,
+        removed
+      );
+
+      if (!removed)
+      {
+        return node;
+      }
+
+      const auto result = memory::make<map::node>(*node);
+
+      if (!child)
+      {
+        result->children.erase(std::begin(result->children) + index);
+        result->child_map &= ~bit;
+      }
+      else if (child->children.empty() && child->entries.size() == 1)
+      {
+        // Child with single entry is inlined, so that the shape of the trie
+        // does not depend on the order of the modifications.
+        result->children.erase(std::begin(result->children) + index);
+        result->child_map &= ~bit;
+        result->entries.insert(
+          std::begin(result->entries) + position(result->entry_map, bit),
+          child->entries[0]
+        );
+        result->entry_map |= bit;
+      } else {
+        result->children[index] = child;
+      }
+
+      return result->entries.empty() && result->children.empty()
+        ? nullptr
+        : result;
+    }
+
+    return node;
+  }
+
+  memory::ref<value::map>
+  value::map::assoc(const value_type& key, const value_type& value) const
+  {
+    bool added = false;
+    const auto root = assoc(m_root, 0, hash(key), entry(key, value), added);
+
+    return memory::ref<map>(new map(
+      root,
+      added ? m_size + 1 : m_size,
+      std::nullopt,
+      std::nullopt
+    ));
+  }
+
+  memory::ref<value::map>
+  value::map::dissoc(const value_type& key) const
+  {
+    bool removed = false;
+    const auto root = m_root
+      ? dissoc(m_root, 0, hash(key), key, removed)
+      : m_root;
+
+    return memory::ref<map>(new map(
+      root,
+      removed ? m_size - 1 : m_size,
+      std::nullopt,
+      std::nullopt
+    ));
+  }
+}
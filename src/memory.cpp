@@ -0,0 +1,97 @@
+#include <bali/memory.hpp>
+
+namespace bali::memory
+{
+  namespace
+  {
+    // Size classes are multiples of granularity, up to the maximum size.
+    const std::size_t granularity = 16;
+    const std::size_t max_size = 512;
+    const std::size_t size_class_count = max_size / granularity;
+    const std::size_t chunk_size = 64 * 1024;
+
+    struct free_block
+    {
+      free_block* next;
+    };
+
+    struct pool
+    {
+      free_block* free_lists[size_class_count] = {};
+      char* chunk_position = nullptr;
+      std::size_t chunk_remaining = 0;
+
+      void* allocate(std::size_t index)
+      {
+        const auto size = (index + 1) * granularity;
+
+        if (const auto block = free_lists[index])
+        {
+          free_lists[index] = block->next;
+
+          return block;
+        }
+        if (chunk_remaining < size)
+        {
+          // Remainder of the previous chunk is wasted, which is at most
+          // the size of the largest size class.
+          chunk_position = static_cast<char*>(::operator new(chunk_size));
+          chunk_remaining = chunk_size;
+        }
+
+        const auto result = chunk_position;
+
+        chunk_position += size;
+        chunk_remaining -= size;
+
+        return result;
+      }
+
+      void deallocate(void* pointer, std::size_t index)
+      {
+        const auto block = static_cast<free_block*>(pointer);
+
+        block->next = free_lists[index];
+        free_lists[index] = block;
+      }
+    };
+  }
+
+  // Pool is never destroyed, as values held in static variables can be
+  // released after everything else during program exit.
+  static inline pool&
+  get_pool()
+  {
+    static pool* instance = new pool();
+
+    return *instance;
+  }
+
+  static inline std::size_t
+  get_size_class(std::size_t size)
+  {
+    return (size + granularity - 1) / granularity - 1;
+  }
+
+  void*
+  allocate(std::size_t size)
+  {
+    if (size == 0 || size > max_size)
+    {
+      return ::operator new(size);
+    }
+
+    return get_pool().allocate(get_size_class(size));
+  }
+
+  void
+  deallocate(void* pointer, std::size_t size)
+  {
+    if (size == 0 || size > max_size)
+    {
+      ::operator delete(pointer);
+      return;
+    }
+    get_pool().deallocate(pointer, get_size_class(size));
+  }
+}
@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+#include <bali/number.hpp>
+#include <bali/utils.hpp>
+
+#if !defined(BALI_NUMBER_BUFFER_SIZE)
+# define BALI_NUMBER_BUFFER_SIZE 64
+#endif
+
+namespace bali
+{
+  using integer_type = number::integer_type;
+  using real_type = number::real_type;
+  using limits = std::numeric_limits<integer_type>;
+
+  // Returns the power of ten of the leading digit of a validated number,
+  // plus one, which tells whether a number out of range overflows or
+  // underflows.
+  static long
+  decimal_exponent(const std::u32string& text)
+  {
+    const auto length = text.length();
+    std::u32string::size_type i = 0;
+    long integer_digits = 0;
+    long leading_zeros = 0;
+    long exponent = 0;
+
+    if (text[0] == U'+' || text[0] == U'-')
+    {
+      ++i;
+    }
+    while (i < length && text[i] == U'0')
+    {
+      ++i;
+    }
+    for (; i < length && text[i] >= U'0' && text[i] <= U'9'; ++i)
+    {
+      ++integer_digits;
+    }
+    if (i < length && text[i] == U'.')
+    {
+      for (++i; i < length && text[i] == U'0'; ++i)
+      {
+        if (!integer_digits)
+        {
+          ++leading_zeros;
+        }
+      }
+      while (i < length && text[i] >= U'0' && text[i] <= U'9')
+      {
+        ++i;
+      }
+    }
+    if (i < length)
+    {
+      bool negative = false;
+
+      if (text[++i] == U'+' || text[i] == U'-')
+      {
+        negative = text[i++] == U'-';
+      }
+      // Exponents beyond this are out of range anyway.
+      for (; i < length && exponent < 100000; ++i)
+      {
+        exponent = exponent * 10 + static_cast<long>(text[i] - U'0');
+      }
+      if (negative)
+      {
+        exponent = -exponent;
+      }
+    }
+
+    return exponent + (integer_digits ? integer_digits : -leading_zeros);
+  }
+
+  // Parses floating point number with std::from_chars(), which is locale
+  // independent and exact. Text has already been validated, so it can be
+  // narrowed into characters on the stack without further checks. Numbers
+  // out of range become infinities or zeroes with the same sign.
+  static number
+  parse_real(const std::u32string& text)
+  {
+    char buffer[BALI_NUMBER_BUFFER_SIZE];
+    std::string overflow;
+    auto begin = std::begin(text);
+    char* input = buffer;
+    real_type result = 0;
+
+    // Leading plus sign is not accepted by std::from_chars().
+    if (*begin == U'+')
+    {
+      ++begin;
+    }
+
+    const auto length = static_cast<std::size_t>(std::end(text) - begin);
+
+    if (length > sizeof(buffer))
+    {
+      overflow.resize(length);
+      input = overflow.data();
+    }
+    std::copy(begin, std::end(text), input);
+    if (
+      std::from_chars(input, input + length, result).ec ==
+      std::errc::result_out_of_range
+    )
+    {
+      result = std::copysign(
+        decimal_exponent(text) > 0
+          ? std::numeric_limits<real_type>::infinity()
+          : real_type(0),
+        text[0] == U'-' ? real_type(-1) : real_type(1)
+      );
+    }
+
+    return result;
+  }
+
+  static number
+  parse_non_finite(const std::u32string& text)
+  {
+    if (text.back() == U'n')
+    {
+      return std::numeric_limits<real_type>::quiet_NaN();
+    }
+
+    return text[0] == U'-'
+      ? -std::numeric_limits<real_type>::infinity()
+      : std::numeric_limits<real_type>::infinity();
+  }
+
+  number::number(const bignum::ptr& value)
+    : m_kind(kind::integer)
+    , m_integer(0)
+  {
+    if (!value->to_integer(m_integer))
+    {
+      m_kind = kind::bignum;
+      m_bignum = value;
+    }
+  }
+
+  number
+  number::parse(const std::u32string& text)
+  {
+    const auto length = text.length();
+    bool negative = false;
+    integer_type result = 0;
+    std::u32string::size_type i = 0;
+
+    if (text.back() == U'f' || text.back() == U'n')
+    {
+      return parse_non_finite(text);
+    }
+    else if (text.find_first_of(U".eE") != std::u32string::npos)
+    {
+      return parse_real(text);
+    }
+    else if (text[0] == U'+' || text[0] == U'-')
+    {
+      negative = text[0] == U'-';
+      ++i;
+    }
+    // Digits are accumulated as a negative number, as the range of negative
+    // integers is larger than the range of positive ones.
+    for (; i < length; ++i)
+    {
+      const integer_type digit = text[i] - U'0';
+
+      if (
+        result < limits::min() / 10 ||
+        result * 10 < limits::min() + digit
+      )
+      {
+        return bignum::parse(text);
+      }
+      result = result * 10 - digit;
+    }
+    if (!negative)
+    {
+      if (result == limits::min())
+      {
+        return bignum::parse(text);
+      }
+      result = -result;
+    }
+
+    return result;
+  }
+
+  bignum::ptr
+  number::to_bignum() const
+  {
+    return m_kind == kind::bignum ? m_bignum : bignum::make(m_integer);
+  }
+
+  number
+  number::operator-() const
+  {
+    if (m_kind == kind::real)
+    {
+      return -m_real;
+    }
+    else if (m_kind == kind::bignum)
+    {
+      return m_bignum->negate();
+    }
+    else if (m_integer == limits::min())
+    {
+      return bignum::make(m_integer)->negate();
+    }
+
+    return -m_integer;
+  }
+
+  number&
+  number::operator+=(const number& that)
+  {
+    if (m_kind == kind::integer && that.m_kind == kind::integer &&
+        !utils::add_overflows(m_integer, that.m_integer))
+    {
+      m_integer += that.m_integer;
+    }
+    else if (is_exact() && that.is_exact())
+    {
+      *this = bignum::add(*to_bignum(), *that.to_bignum());
+    } else {
+      *this = real() + that.real();
+    }
+
+    return *this;
+  }
+
+  number&
+  number::operator-=(const number& that)
+  {
+    if (m_kind == kind::integer && that.m_kind == kind::integer &&
+        !utils::subtract_overflows(m_integer, that.m_integer))
+    {
+      m_integer -= that.m_integer;
+    }
+    else if (is_exact() && that.is_exact())
+    {
+      *this = bignum::subtract(*to_bignum(), *that.to_bignum());
+    } else {
+      *this = real() - that.real();
+    }
+
+    return *this;
+  }
+
+  number&
+  number::operator*=(const number& that)
+  {
+    if (m_kind == kind::integer && that.m_kind == kind::integer &&
+        !utils::multiply_overflows(m_integer, that.m_integer))
+    {
+      m_integer *= that.m_integer;
+    }
+    else if (is_exact() && that.is_exact())
+    {
+      *this = bignum::multiply(*to_bignum(), *that.to_bignum());
+    } else {
+      *this = real() * that.real();
+    }
+
+    return *this;
+  }
+
+  number&
+  number::operator/=(const number& that)
+  {
+    // Division of the smallest integer by -1 is the only one that
+    // overflows, so it's left for the bignums.
+    if (
+      m_kind == kind::integer &&
+      that.m_kind == kind::integer &&
+      !(m_integer == limits::min() && that.m_integer == -1)
+    )
+    {
+      if (m_integer % that.m_integer == 0)
+      {
+        m_integer /= that.m_integer;
+
+        return *this;
+      }
+    }
+    else if (is_exact() && that.is_exact())
+    {
+      bignum::ptr quotient;
+      bignum::ptr remainder;
+
+      bignum::divide(*to_bignum(), *that.to_bignum(), quotient, remainder);
+      if (remainder->is_zero())
+      {
+        return *this = quotient;
+      }
+    }
+
+    return *this = real() / that.real();
+  }
+
+  std::u32string
+  number::to_string() const
+  {
+    char buffer[BALI_NUMBER_BUFFER_SIZE];
+    std::to_chars_result result;
+
+    if (m_kind == kind::bignum)
+    {
+      return m_bignum->to_string();
+    }
+    else if (m_kind == kind::integer)
+    {
+      result = std::to_chars(buffer, buffer + sizeof(buffer), m_integer);
+    }
+    else if (!std::isfinite(m_real))
+    {
+      return std::isnan(m_real) ? U"nan" : m_real < 0 ? U"-inf" : U"inf";
+    } else {
+      // Shortest representation that parses back into the same number.
+      // Integral values get a fractional part, so that they are read back
+      // as floating point numbers instead of integers.
+      result = std::to_chars(buffer, buffer + sizeof(buffer), m_real);
+      if (std::find_if(buffer, result.ptr, [](char c)
+      {
+        return c == '.' || c == 'e';
+      }) == result.ptr)
+      {
+        *result.ptr++ = '.';
+        *result.ptr++ = '0';
+      }
+    }
+
+    return std::u32string(buffer, result.ptr);
+  }
+
+  // Converts integral floating point number that is too large for 64 bits
+  // into a bignum without rounding.
+  static bignum::ptr
+  to_bignum(real_type value)
+  {
+    int exponent;
+    const auto mantissa = std::frexp(value, &exponent);
+    auto result = bignum::make(static_cast<integer_type>(
+      std::ldexp(mantissa, limits::digits)
+    ));
+
+    for (exponent -= limits::digits; exponent > 0; exponent -= 32)
+    {
+      result = bignum::multiply(
+        *result,
+        *bignum::make(integer_type(1) << std::min(exponent, 32))
+      );
+    }
+
+    return result;
+  }
+
+  // Compares exact number with finite floating point number without
+  // rounding either of them. Rounding preserves order, so the numbers
+  // need to be compared exactly only if the exact number rounds into the
+  // floating point number, which is then integral.
+  static int
+  compare_exact(const number& exact, real_type real)
+  {
+    const auto rounded = exact.real();
+
+    if (rounded != real)
+    {
+      return rounded < real ? -1 : 1;
+    }
+    else if (
+      exact.is_integer() &&
+      real >= -9223372036854775808.0 &&
+      real < 9223372036854775808.0
+    )
+    {
+      const auto integer = static_cast<integer_type>(real);
+
+      return exact.integer() < integer ? -1 : exact.integer() > integer;
+    }
+
+    return bignum::compare(*exact.to_bignum(), *to_bignum(real));
+  }
+
+  // Integers are compared with floating point numbers exactly, so that
+  // numbers that are equal are the same number regardless of how they are
+  // stored, and hash the same in maps.
+  bool
+  operator==(const number& a, const number& b)
+  {
+    if (a.is_integer() && b.is_integer())
+    {
+      return a.integer() == b.integer();
+    }
+    else if (a.is_exact() && b.is_exact())
+    {
+      return !bignum::compare(*a.to_bignum(), *b.to_bignum());
+    }
+    else if (a.is_exact() && std::isfinite(b.real()))
+    {
+      return !compare_exact(a, b.real());
+    }
+    else if (b.is_exact() && std::isfinite(a.real()))
+    {
+      return !compare_exact(b, a.real());
+    }
+
+    return a.real() == b.real();
+  }
+
+  bool
+  operator<(const number& a, const number& b)
+  {
+    if (a.is_integer() && b.is_integer())
+    {
+      return a.integer() < b.integer();
+    }
+    else if (a.is_exact() && b.is_exact())
+    {
+      return bignum::compare(*a.to_bignum(), *b.to_bignum()) < 0;
+    }
+    else if (a.is_exact() && std::isfinite(b.real()))
+    {
+      return compare_exact(a, b.real()) < 0;
+    }
+    else if (b.is_exact() && std::isfinite(a.real()))
+    {
+      return compare_exact(b, a.real()) > 0;
+    }
+
+    return a.real() < b.real();
+  }
+}
@@ -0,0 +1,156 @@
+#include <cstring>
+#include <memory>
+
+#if defined(_WIN32)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include <bali/port.hpp>
+
+#if !defined(BALI_PORT_BUFFER_SIZE)
+# define BALI_PORT_BUFFER_SIZE 65536
+#endif
+
+namespace bali
+{
+  static std::unique_ptr<port> file_port;
+
+  static inline bool
+  is_terminal(std::FILE* file)
+  {
+#if defined(_WIN32)
+    return _isatty(_fileno(file));
+#else
+    return isatty(fileno(file));
+#endif
+  }
+
+  port&
+  port::standard()
+  {
+    static port instance(stdout);
+
+    return instance;
+  }
+
+  port&
+  port::current()
+  {
+    return file_port ? *file_port : standard();
+  }
+
+  bool
+  port::redirect(const std::string& filename)
+  {
+    const auto file = std::fopen(filename.c_str(), "wb");
+
+    if (!file)
+    {
+      return false;
+    }
+    file_port = std::make_unique<port>(file, true);
+
+    return true;
+  }
+
+  port::port(std::FILE* file, bool owned)
+    : m_file(file)
+    , m_owned(owned)
+    , m_line_buffered(is_terminal(file))
+    , m_buffer(BALI_PORT_BUFFER_SIZE)
+    , m_stream(this)
+  {
+    // Files owned by the port are buffered only by the port itself.
+    if (owned)
+    {
+      std::setvbuf(file, nullptr, _IONBF, 0);
+    }
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+  }
+
+  port::~port()
+  {
+    sync();
+    if (m_owned)
+    {
+      std::fclose(m_file);
+    }
+  }
+
+  void
+  port::end_line()
+  {
+    sputc('\n');
+    if (m_line_buffered)
+    {
+      sync();
+    }
+  }
+
+  void
+  port::flush()
+  {
+    sync();
+  }
+
+  port::int_type
+  port::overflow(int_type c)
+  {
+    if (!drain())
+    {
+      return traits_type::eof();
+    }
+    else if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+  // Text that does not fit into the buffer even when it's empty is written
+  // directly into the file.
+  std::streamsize
+  port::xsputn(const char* data, std::streamsize size)
+  {
+    if (size > epptr() - pptr())
+    {
+      if (!drain())
+      {
+        return 0;
+      }
+      else if (size > epptr() - pptr())
+      {
+        return static_cast<std::streamsize>(
+          std::fwrite(data, 1, static_cast<std::size_t>(size), m_file)
+        );
+      }
+    }
+    std::memcpy(pptr(), data, static_cast<std::size_t>(size));
+    pbump(static_cast<int>(size));
+
+    return size;
+  }
+
+  int
+  port::sync()
+  {
+    return drain() && !std::fflush(m_file) ? 0 : -1;
+  }
+
+  bool
+  port::drain()
+  {
+    const auto size = static_cast<std::size_t>(pptr() - pbase());
+    const auto written = size > 0
+      ? std::fwrite(pbase(), 1, size, m_file)
+      : 0;
+
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+
+    return written == size;
+  }
+}
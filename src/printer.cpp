@@ -0,0 +1,273 @@
+#include <cstring>
+#include <vector>
+
+#include <peelo/unicode/encoding/utf8.hpp>
+
+#include <bali/printer.hpp>
+
+namespace bali
+{
+  namespace
+  {
+    // Value whose elements are being printed.
+    struct frame
+    {
+      value::ptr container;
+      std::size_t index;
+      std::size_t size;
+      char closing;
+      // Keys and values of a map in the order they are printed, as maps can
+      // only be traversed with a callback.
+      std::vector<value::ptr> entries;
+    };
+  }
+
+  static inline void
+  put(std::streambuf& output, const char* text)
+  {
+    output.sputn(text, static_cast<std::streamsize>(std::strlen(text)));
+  }
+
+  // Characters outside of ASCII are encoded one at a time, so that text is
+  // never encoded into a temporary string as a whole.
+  static void
+  put(std::streambuf& output, const std::u32string& text)
+  {
+    using peelo::unicode::encoding::utf8::encode;
+
+    for (const auto c : text)
+    {
+      if (c < 0x80)
+      {
+        output.sputc(static_cast<char>(c));
+      } else {
+        const auto sequence = encode(c);
+
+        output.sputn(
+          sequence.data(),
+          static_cast<std::streamsize>(sequence.size())
+        );
+      }
+    }
+  }
+
+  static void
+  put_function(
+    std::streambuf& output,
+    const memory::ref<value::function>& function,
+    std::vector<frame>& stack
+  )
+  {
+    const auto custom = memory::dynamic_pointer_cast<value::function::custom>(
+      function
+    );
+    bool first = true;
+
+    if (!custom)
+    {
+      put(output, "<builtin function: ");
+      put(output, *function->name());
+      output.sputc('>');
+      return;
+    }
+    else if (const auto& name = custom->name())
+    {
+      put(output, "(defun ");
+      put(output, *name);
+      put(output, " (");
+    } else {
+      put(output, "(lambda (");
+    }
+    for (const auto parameter : custom->parameters())
+    {
+      if (first)
+      {
+        first = false;
+      } else {
+        output.sputc(' ');
+      }
+      put(output, symbol::name(parameter));
+    }
+    put(output, ") ");
+    stack.push_back({ function, 0, 1, ')', {} });
+  }
+
+  static void
+  put_array(std::streambuf& output, const memory::ref<value::array>& array)
+  {
+    const auto size = array->size();
+
+    put(output, array->is_integer() ? "#s64(" : "#f64(");
+    for (value::array::size_type i = 0; i < size; ++i)
+    {
+      if (i > 0)
+      {
+        output.sputc(' ');
+      }
+      put(output, array->at(i).to_string());
+    }
+    output.sputc(')');
+  }
+
+  // Immediate atoms are written without allocating an atom for them.
+  static void
+  put_atom(std::streambuf& output, const value::ptr& value)
+  {
+    number number;
+
+    if (value.is_symbol())
+    {
+      put(output, symbol::name(value.symbol()));
+    }
+    else if (value.is_immediate() && value.as_number(number))
+    {
+      put(output, number.to_string());
+    } else {
+      put(output, memory::static_pointer_cast<value::atom>(value)->symbol());
+    }
+  }
+
+  // Writes the value, or if it has elements, only the beginning of it and
+  // pushes a frame for printing the elements.
+  static void
+  begin(
+    std::streambuf& output,
+    const value::ptr& value,
+    std::vector<frame>& stack
+  )
+  {
+    if (!value)
+    {
+      put(output, "nil");
+      return;
+    }
+
+    switch (value->type())
+    {
+      case value::type::atom:
+        put_atom(output, value);
+        break;
+
+      case value::type::function:
+        put_function(
+          output,
+          memory::static_pointer_cast<value::function>(value),
+          stack
+        );
+        break;
+
+      case value::type::list:
+        output.sputc('(');
+        stack.push_back({
+          value,
+          0,
+          memory::static_pointer_cast<value::list>(value)->size(),
+          ')',
+          {}
+        });
+        break;
+
+      case value::type::array:
+        put_array(output, memory::static_pointer_cast<value::array>(value));
+        break;
+
+      case value::type::vector:
+        put(output, "#(");
+        stack.push_back({
+          value,
+          0,
+          memory::static_pointer_cast<value::vector>(value)->size(),
+          ')',
+          {}
+        });
+        break;
+
+      case value::type::map:
+        {
+          std::vector<value::ptr> entries;
+
+          memory::static_pointer_cast<value::map>(value)->for_each([&](
+            const value::ptr& key,
+            const value::ptr& entry
+          )
+          {
+            entries.push_back(key);
+            entries.push_back(entry);
+          });
+          output.sputc('{');
+          stack.push_back({
+            value,
+            0,
+            entries.size(),
+            '}',
+            std::move(entries)
+          });
+        }
+        break;
+
+      case value::type::sequence:
+        put(output, "<sequence>");
+        break;
+    }
+  }
+
+  static value::ptr
+  element(const frame& frame)
+  {
+    const auto& container = frame.container;
+
+    switch (container->type())
+    {
+      case value::type::list:
+        return memory::static_pointer_cast<value::list>(
+          container
+        )->elements()[frame.index];
+
+      case value::type::vector:
+        return memory::static_pointer_cast<value::vector>(
+          container
+        )->at(frame.index);
+
+      case value::type::map:
+        return frame.entries[frame.index];
+
+      case value::type::function:
+        return memory::static_pointer_cast<value::function::custom>(
+          container
+        )->expression();
+
+      case value::type::atom:
+      case value::type::array:
+      case value::type::sequence:
+        break;
+    }
+
+    return nullptr;
+  }
+
+  void
+  print(std::streambuf& output, const value::ptr& value)
+  {
+    std::vector<frame> stack;
+
+    begin(output, value, stack);
+    while (!stack.empty())
+    {
+      auto& top = stack.back();
+
+      if (top.index < top.size)
+      {
+        const auto next = element(top);
+
+        if (top.index++ > 0)
+        {
+          output.sputc(' ');
+        }
+        begin(output, next, stack);
+      } else {
+        output.sputc(top.closing);
+        stack.pop_back();
+      }
+    }
+  }
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+
+#include <bali/resolver.hpp>
+
+namespace bali
+{
+  using frame_type = std::vector<symbol::id>;
+  using environment_type = std::vector<frame_type>;
+
+  static value::ptr
+  resolve_value(const value::ptr& value, environment_type& environment);
+
+  static void
+  declare(frame_type& frame, symbol::id name)
+  {
+    if (std::find(std::begin(frame), std::end(frame), name) == std::end(frame))
+    {
+      frame.push_back(name);
+    }
+  }
+
+  static std::optional<value::atom::lexical_address>
+  lookup(const environment_type& environment, symbol::id name)
+  {
+    const auto size = environment.size();
+
+    for (environment_type::size_type depth = 0; depth < size; ++depth)
+    {
+      const auto& frame = environment[size - depth - 1];
+      const auto it = std::find(std::begin(frame), std::end(frame), name);
+
+      if (it != std::end(frame))
+      {
+        return value::atom::lexical_address{
+          static_cast<std::uint32_t>(depth),
+          static_cast<std::uint32_t>(std::distance(std::begin(frame), it))
+        };
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  static value::ptr
+  resolve_atom(
+    const memory::ref<value::atom>& atom,
+    const environment_type& environment
+  )
+  {
+    if (!atom->is_interned())
+    {
+      return atom;
+    }
+    else if (const auto address = lookup(environment, atom->id()))
+    {
+      return value::atom::make(atom->id(), *address, *atom);
+    }
+    else if (atom->address())
+    {
+      return value::atom::make(atom->id(), *atom);
+    }
+
+    return atom;
+  }
+
+  static value::ptr
+  resolve_elements(
+    const memory::ref<value::list>& list,
+    environment_type& environment
+  )
+  {
+    const auto& elements = list->elements();
+    const auto size = elements.size();
+    value::list::container_type result(
+      std::begin(elements),
+      std::end(elements)
+    );
+    bool changed = false;
+
+    for (value::list::size_type i = 0; i < size; ++i)
+    {
+      result[i] = resolve_value(elements[i], environment);
+      changed = changed || result[i] != elements[i];
+    }
+
+    return changed
+      ? value::list::make(result, *list)
+      : list;
+  }
+
+  // Resolves `(let (bindings...) body...)` form. Initial values of the
+  // bindings are resolved in the enclosing scope and the body in a new scope
+  // that has a slot for each distinct binding, in the same order as `let`
+  // declares them during evaluation. Malformed forms are left as they are,
+  // as they will fail during evaluation anyway.
+  static value::ptr
+  resolve_let(
+    const memory::ref<value::list>& list,
+    environment_type& environment
+  )
+  {
+    const auto& elements = list->elements();
+    value::list::container_type bindings;
+    frame_type frame;
+
+    if (
+      elements.size() < 2 ||
+      !elements[1] ||
+      elements[1]->type() != value::type::list
+    )
+    {
+      return list;
+    }
+
+    for (const auto& entry : memory::static_pointer_cast<value::list>(
+      elements[1]
+    )->elements())
+    {
+      value::ptr name = entry;
+      value::ptr initial_value;
+
+      if (entry && entry->type() == value::type::list)
+      {
+        const auto& pair = memory::static_pointer_cast<value::list>(
+          entry
+        )->elements();
+
+        if (pair.size() != 2)
+        {
+          return list;
+        }
+        name = pair[0];
+        initial_value = resolve_value(pair[1], environment);
+      }
+      if (
+        !name ||
+        name->type() != value::type::atom ||
+        !memory::static_pointer_cast<value::atom>(name)->is_interned()
+      )
+      {
+        return list;
+      }
+      declare(frame, memory::static_pointer_cast<value::atom>(name)->id());
+      bindings.push_back(
+        entry->type() == value::type::list
+          ? value::list::make({ name, initial_value }, *entry)
+          : entry
+      );
+    }
+
+    value::list::container_type result(
+      std::begin(elements),
+      std::end(elements)
+    );
+
+    result[1] = value::list::make(bindings, *elements[1]);
+    environment.push_back(frame);
+    for (value::list::size_type i = 2; i < elements.size(); ++i)
+    {
+      result[i] = resolve_value(elements[i], environment);
+    }
+    environment.pop_back();
+
+    return value::list::make(result, *list);
+  }
+
+  // Resolves `(dotimes (name count) body...)` form. The count is resolved in
+  // the enclosing scope and the body in a new scope that has a slot only for
+  // the counter.
+  static value::ptr
+  resolve_dotimes(
+    const memory::ref<value::list>& list,
+    environment_type& environment
+  )
+  {
+    const auto& elements = list->elements();
+
+    if (
+      elements.size() < 2 ||
+      !elements[1] ||
+      elements[1]->type() != value::type::list
+    )
+    {
+      return list;
+    }
+
+    const auto specification = memory::static_pointer_cast<value::list>(
+      elements[1]
+    );
+    const auto& pair = specification->elements();
+
+    if (
+      pair.size() != 2 ||
+      !pair[0] ||
+      pair[0]->type() != value::type::atom ||
+      !memory::static_pointer_cast<value::atom>(pair[0])->is_interned()
+    )
+    {
+      return list;
+    }
+
+    value::list::container_type result(
+      std::begin(elements),
+      std::end(elements)
+    );
+
+    result[1] = value::list::make(
+      { pair[0], resolve_value(pair[1], environment) },
+      *specification
+    );
+    environment.push_back({
+      memory::static_pointer_cast<value::atom>(pair[0])->id()
+    });
+    for (value::list::size_type i = 2; i < elements.size(); ++i)
+    {
+      result[i] = resolve_value(elements[i], environment);
+    }
+    environment.pop_back();
+
+    return value::list::make(result, *list);
+  }
+
+  static value::ptr
+  resolve_list(
+    const memory::ref<value::list>& list,
+    environment_type& environment
+  )
+  {
+    const auto& elements = list->elements();
+
+    if (elements.empty())
+    {
+      return list;
+    }
+
+    if (elements[0] && elements[0]->type() == value::type::atom)
+    {
+      const auto head = memory::static_pointer_cast<value::atom>(elements[0]);
+
+      if (head->is_interned() && !lookup(environment, head->id()))
+      {
+        switch (head->id())
+        {
+          // Quoted data is not evaluated and bodies of nested functions are
+          // resolved separately once the function is created.
+          case symbol::quote:
+          case symbol::lambda:
+          case symbol::defun:
+            return list;
+
+          // Variables of `loop` are bound just like the ones of `let`.
+          case symbol::let:
+          case symbol::loop:
+            return resolve_let(list, environment);
+
+          case symbol::dotimes:
+            return resolve_dotimes(list, environment);
+        }
+      }
+    }
+
+    return resolve_elements(list, environment);
+  }
+
+  static value::ptr
+  resolve_value(const value::ptr& value, environment_type& environment)
+  {
+    if (!value)
+    {
+      return value;
+    }
+
+    switch (value->type())
+    {
+      case value::type::atom:
+        return resolve_atom(
+          memory::static_pointer_cast<value::atom>(value),
+          environment
+        );
+
+      case value::type::list:
+        return resolve_list(
+          memory::static_pointer_cast<value::list>(value),
+          environment
+        );
+
+      case value::type::function:
+      case value::type::array:
+      case value::type::vector:
+      case value::type::map:
+      case value::type::sequence:
+        break;
+    }
+
+    return value;
+  }
+
+  value::ptr
+  resolve(
+    const std::vector<symbol::id>& parameters,
+    const value::ptr& expression
+  )
+  {
+    environment_type environment;
+
+    // Custom functions without parameters are evaluated in the scope of the
+    // caller, so there is no scope for the parameters either.
+    if (!parameters.empty())
+    {
+      frame_type frame;
+
+      for (const auto& parameter : parameters)
+      {
+        declare(frame, parameter);
+      }
+      environment.push_back(frame);
+    }
+
+    return resolve_value(expression, environment);
+  }
+}
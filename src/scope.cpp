@@ -1,53 +1,149 @@
+#include <algorithm>
+
 #include <bali/scope.hpp>
 
 namespace bali
 {
-  scope::scope(const std::shared_ptr<scope>& parent)
-    : m_parent(parent) {}
+  scope::scope(const memory::ref<scope>& parent, size_type size)
+    : m_parent(parent)
+  {
+    m_slots.reserve(size);
+  }
 
   bool
-  scope::get(const std::u32string& name, value::ptr& slot) const
+  scope::get(symbol::id name, value::ptr& slot) const
   {
-    const auto it = m_variables.find(name);
-
-    if (it != std::end(m_variables))
+    for (auto current = this; current; current = current->m_parent.get())
     {
-      slot = it->second;
+      if (const auto variable = current->find(name))
+      {
+        slot = *variable;
 
-      return true;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void
+  scope::let(symbol::id name, const value::ptr& value)
+  {
+    if (const auto variable = find(name))
+    {
+      *variable = value;
     }
     else if (m_parent)
     {
-      return m_parent->get(name, slot);
+      m_slots.emplace_back(name, value);
+    } else {
+      m_variables[name] = value;
     }
-
-    return false;
   }
 
   void
-  scope::let(const std::u32string& name, const value::ptr& value)
+  scope::set(symbol::id name, const value::ptr& value)
+  {
+    for (auto current = this; current; current = current->m_parent.get())
+    {
+      if (const auto variable = current->find(name))
+      {
+        *variable = value;
+        return;
+      }
+    }
+
+    let(name, value);
+  }
+
+  const value::ptr&
+  scope::at(const value::atom::lexical_address& address) const
   {
-    m_variables[name] = value;
+    auto current = this;
+
+    for (auto depth = address.depth; depth > 0; --depth)
+    {
+      current = current->m_parent.get();
+    }
+
+    return current->m_slots[address.index].second;
   }
 
   void
-  scope::set(const std::u32string& name, const value::ptr& value)
+  scope::drop_shadowed(const memory::ref<scope>& ancestor)
   {
-    if (m_variables.find(name) != std::end(m_variables))
+    std::vector<symbol::id> names;
+    auto current = this;
+
+    if (current == ancestor.get())
     {
-      m_variables[name] = value;
       return;
     }
+    for (const auto& slot : current->m_slots)
+    {
+      names.push_back(slot.first);
+    }
+    while (
+      current->m_parent &&
+      current->m_parent != ancestor &&
+      current->m_parent->m_parent
+    )
+    {
+      const auto parent = current->m_parent;
 
-    for (auto parent = m_parent; parent; parent = parent->m_parent)
+      if (std::all_of(
+        std::begin(parent->m_slots),
+        std::end(parent->m_slots),
+        [&names](const slot_type& slot)
+        {
+          return std::find(
+            std::begin(names),
+            std::end(names),
+            slot.first
+          ) != std::end(names);
+        }
+      ))
+      {
+        current->m_parent = parent->m_parent;
+        continue;
+      }
+      current = parent.get();
+      for (const auto& slot : current->m_slots)
+      {
+        names.push_back(slot.first);
+      }
+    }
+  }
+
+  value::ptr*
+  scope::find(symbol::id name)
+  {
+    return const_cast<value::ptr*>(
+      static_cast<const scope*>(this)->find(name)
+    );
+  }
+
+  const value::ptr*
+  scope::find(symbol::id name) const
+  {
+    if (m_parent)
     {
-      if (parent->m_variables.find(name) != std::end(parent->m_variables))
+      for (const auto& slot : m_slots)
       {
-        parent->m_variables[name] = value;
-        return;
+        if (slot.first == name)
+        {
+          return &slot.second;
+        }
+      }
+    } else {
+      const auto it = m_variables.find(name);
+
+      if (it != std::end(m_variables))
+      {
+        return &it->second;
       }
     }
 
-    m_variables[name] = value;
+    return nullptr;
   }
 }
@@ -0,0 +1,377 @@
+#include <bali/eval.hpp>
+
+namespace bali
+{
+  using cursor = value::sequence::cursor;
+  using cursor_ptr = std::unique_ptr<cursor>;
+
+  class value::sequence::stage : public memory::counted
+  {
+  public:
+    virtual cursor_ptr iterate() const = 0;
+  };
+
+  namespace
+  {
+    using stage = value::sequence::stage;
+    using stage_ptr = memory::ref<stage>;
+    using function_ptr = memory::ref<value::function>;
+
+    class range_cursor final : public cursor
+    {
+    public:
+      explicit range_cursor(
+        const number& start,
+        const std::optional<number>& end,
+        const number& step
+      )
+        : m_current(start)
+        , m_end(end)
+        , m_step(step) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>&)
+      {
+        if (m_end && (m_step > 0 ? m_current >= *m_end : m_current <= *m_end))
+        {
+          return false;
+        }
+        slot = value::atom::make_number(m_current);
+        m_current += m_step;
+
+        return true;
+      }
+
+    private:
+      number m_current;
+      const std::optional<number> m_end;
+      const number m_step;
+    };
+
+    class range_stage final : public stage
+    {
+    public:
+      explicit range_stage(
+        const number& start,
+        const std::optional<number>& end,
+        const number& step
+      )
+        : m_start(start)
+        , m_end(end)
+        , m_step(step) {}
+
+      cursor_ptr iterate() const
+      {
+        return std::make_unique<range_cursor>(m_start, m_end, m_step);
+      }
+
+    private:
+      const number m_start;
+      const std::optional<number> m_end;
+      const number m_step;
+    };
+
+    class elements_cursor final : public cursor
+    {
+    public:
+      explicit elements_cursor(const value::ptr& collection)
+        : m_collection(collection)
+        , m_index(0) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>&)
+      {
+        if (m_collection->type() == value::type::vector)
+        {
+          const auto vector = static_cast<const value::vector*>(
+            m_collection.get()
+          );
+
+          if (m_index >= vector->size())
+          {
+            return false;
+          }
+          slot = vector->at(m_index++);
+        } else {
+          const auto elements = static_cast<const value::list*>(
+            m_collection.get()
+          )->elements();
+
+          if (m_index >= elements.size())
+          {
+            return false;
+          }
+          slot = elements[m_index++];
+        }
+
+        return true;
+      }
+
+    private:
+      const value::ptr m_collection;
+      std::size_t m_index;
+    };
+
+    class elements_stage final : public stage
+    {
+    public:
+      explicit elements_stage(const value::ptr& collection)
+        : m_collection(collection) {}
+
+      cursor_ptr iterate() const
+      {
+        return std::make_unique<elements_cursor>(m_collection);
+      }
+
+    private:
+      const value::ptr m_collection;
+    };
+
+    class map_cursor final : public cursor
+    {
+    public:
+      explicit map_cursor(cursor_ptr&& source, const function_ptr& callback)
+        : m_source(std::move(source))
+        , m_callback(callback) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>& scope)
+      {
+        value::ptr element;
+
+        if (!m_source->next(element, scope))
+        {
+          return false;
+        }
+        slot = m_callback->call(&element, &element + 1, scope);
+
+        return true;
+      }
+
+    private:
+      const cursor_ptr m_source;
+      const function_ptr m_callback;
+    };
+
+    class filter_cursor final : public cursor
+    {
+    public:
+      explicit filter_cursor(
+        cursor_ptr&& source,
+        const function_ptr& callback
+      )
+        : m_source(std::move(source))
+        , m_callback(callback) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>& scope)
+      {
+        while (m_source->next(slot, scope))
+        {
+          if (is_returning())
+          {
+            return false;
+          }
+          else if (to_bool(m_callback->call(&slot, &slot + 1, scope), nullptr))
+          {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+    private:
+      const cursor_ptr m_source;
+      const function_ptr m_callback;
+    };
+
+    class take_cursor final : public cursor
+    {
+    public:
+      explicit take_cursor(cursor_ptr&& source, std::size_t count)
+        : m_source(std::move(source))
+        , m_remaining(count) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>& scope)
+      {
+        if (!m_remaining)
+        {
+          return false;
+        }
+        --m_remaining;
+
+        return m_source->next(slot, scope);
+      }
+
+    private:
+      const cursor_ptr m_source;
+      std::size_t m_remaining;
+    };
+
+    class take_while_cursor final : public cursor
+    {
+    public:
+      explicit take_while_cursor(
+        cursor_ptr&& source,
+        const function_ptr& callback
+      )
+        : m_source(std::move(source))
+        , m_callback(callback)
+        , m_done(false) {}
+
+      bool next(value::ptr& slot, const memory::ref<class scope>& scope)
+      {
+        if (
+          m_done ||
+          !m_source->next(slot, scope) ||
+          !to_bool(m_callback->call(&slot, &slot + 1, scope), nullptr)
+        )
+        {
+          m_done = true;
+
+          return false;
+        }
+
+        return true;
+      }
+
+    private:
+      const cursor_ptr m_source;
+      const function_ptr m_callback;
+      bool m_done;
+    };
+
+    enum class operation
+    {
+      map,
+      filter,
+      take_while,
+    };
+
+    class callback_stage final : public stage
+    {
+    public:
+      explicit callback_stage(
+        operation op,
+        const stage_ptr& source,
+        const function_ptr& callback
+      )
+        : m_operation(op)
+        , m_source(source)
+        , m_callback(callback) {}
+
+      cursor_ptr iterate() const
+      {
+        auto source = m_source->iterate();
+
+        switch (m_operation)
+        {
+          case operation::map:
+            return std::make_unique<map_cursor>(std::move(source), m_callback);
+
+          case operation::filter:
+            return std::make_unique<filter_cursor>(
+              std::move(source),
+              m_callback
+            );
+
+          case operation::take_while:
+            return std::make_unique<take_while_cursor>(
+              std::move(source),
+              m_callback
+            );
+        }
+
+        return nullptr;
+      }
+
+    private:
+      const operation m_operation;
+      const stage_ptr m_source;
+      const function_ptr m_callback;
+    };
+
+    class take_stage final : public stage
+    {
+    public:
+      explicit take_stage(const stage_ptr& source, std::size_t count)
+        : m_source(source)
+        , m_count(count) {}
+
+      cursor_ptr iterate() const
+      {
+        return std::make_unique<take_cursor>(m_source->iterate(), m_count);
+      }
+
+    private:
+      const stage_ptr m_source;
+      const std::size_t m_count;
+    };
+  }
+
+  value::sequence::sequence(const memory::ref<stage>& stage)
+    : value::value(std::nullopt, std::nullopt)
+    , m_stage(stage) {}
+
+  value::sequence::~sequence() {}
+
+  memory::ref<value::sequence>
+  value::sequence::make_range(
+    const bali::number& start,
+    const std::optional<bali::number>& end,
+    const bali::number& step
+  )
+  {
+    return memory::ref<sequence>(new sequence(
+      memory::make<range_stage>(start, end, step)
+    ));
+  }
+
+  memory::ref<value::sequence>
+  value::sequence::make_elements(const value::ptr& collection)
+  {
+    if (!collection)
+    {
+      return make_range(0, 0, 1);
+    }
+
+    return memory::ref<sequence>(new sequence(
+      memory::make<elements_stage>(collection)
+    ));
+  }
+
+  memory::ref<value::sequence>
+  value::sequence::map(const memory::ref<function>& callback) const
+  {
+    return memory::ref<sequence>(new sequence(
+      memory::make<callback_stage>(operation::map, m_stage, callback)
+    ));
+  }
+
+  memory::ref<value::sequence>
+  value::sequence::filter(const memory::ref<function>& callback) const
+  {
+    return memory::ref<sequence>(new sequence(
+      memory::make<callback_stage>(operation::filter, m_stage, callback)
+    ));
+  }
+
+  memory::ref<value::sequence>
+  value::sequence::take(size_type count) const
+  {
+    return memory::ref<sequence>(new sequence(
+      memory::make<take_stage>(m_stage, count)
+    ));
+  }
+
+  memory::ref<value::sequence>
+  value::sequence::take_while(const memory::ref<function>& callback) const
+  {
+    return memory::ref<sequence>(new sequence(
+      memory::make<callback_stage>(operation::take_while, m_stage, callback)
+    ));
+  }
+
+  std::unique_ptr<value::sequence::cursor>
+  value::sequence::iterate() const
+  {
+    return m_stage->iterate();
+  }
+}
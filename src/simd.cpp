@@ -0,0 +1,789 @@
+#include <algorithm>
+
+#include <bali/simd.hpp>
+#include <bali/utils.hpp>
+
+#if !defined(BALI_NO_SIMD) && defined(__AVX2__)
+# include <immintrin.h>
+# define BALI_SIMD_LANES 4
+#elif !defined(BALI_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+# include <emmintrin.h>
+# define BALI_SIMD_LANES 2
+#endif
+
+namespace bali::simd
+{
+#if defined(BALI_SIMD_LANES)
+  static constexpr size_type lanes = BALI_SIMD_LANES;
+
+# if BALI_SIMD_LANES == 4
+  using real_vector = __m256d;
+  using integer_vector = __m256i;
+
+  static inline real_vector load(const real_type* pointer)
+  {
+    return _mm256_loadu_pd(pointer);
+  }
+
+  static inline integer_vector load(const integer_type* pointer)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer));
+  }
+
+  static inline void store(real_type* pointer, real_vector vector)
+  {
+    _mm256_storeu_pd(pointer, vector);
+  }
+
+  static inline void store(integer_type* pointer, integer_vector vector)
+  {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pointer), vector);
+  }
+
+  static inline real_vector splat(real_type value)
+  {
+    return _mm256_set1_pd(value);
+  }
+
+  static inline integer_vector splat(integer_type value)
+  {
+    return _mm256_set1_epi64x(value);
+  }
+
+  static inline real_vector add(real_vector a, real_vector b)
+  {
+    return _mm256_add_pd(a, b);
+  }
+
+  static inline real_vector subtract(real_vector a, real_vector b)
+  {
+    return _mm256_sub_pd(a, b);
+  }
+
+  static inline real_vector multiply(real_vector a, real_vector b)
+  {
+    return _mm256_mul_pd(a, b);
+  }
+
+  static inline real_vector divide(real_vector a, real_vector b)
+  {
+    return _mm256_div_pd(a, b);
+  }
+
+  static inline real_vector min(real_vector a, real_vector b)
+  {
+    return _mm256_min_pd(a, b);
+  }
+
+  static inline real_vector max(real_vector a, real_vector b)
+  {
+    return _mm256_max_pd(a, b);
+  }
+
+  static inline integer_vector add(integer_vector a, integer_vector b)
+  {
+    return _mm256_add_epi64(a, b);
+  }
+
+  static inline integer_vector subtract(integer_vector a, integer_vector b)
+  {
+    return _mm256_sub_epi64(a, b);
+  }
+
+  static inline integer_vector bitwise_and(integer_vector a, integer_vector b)
+  {
+    return _mm256_and_si256(a, b);
+  }
+
+  static inline integer_vector bitwise_or(integer_vector a, integer_vector b)
+  {
+    return _mm256_or_si256(a, b);
+  }
+
+  static inline integer_vector bitwise_xor(integer_vector a, integer_vector b)
+  {
+    return _mm256_xor_si256(a, b);
+  }
+
+  static inline bool any_negative(integer_vector vector)
+  {
+    return _mm256_movemask_pd(_mm256_castsi256_pd(vector)) != 0;
+  }
+
+  // Comparisons produce lanes with all bits set or cleared.
+  template<comparison op>
+  static inline integer_vector compare(real_vector a, real_vector b)
+  {
+    if constexpr (op == comparison::equal)
+    {
+      return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+    }
+    else if constexpr (op == comparison::less)
+    {
+      return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_LT_OQ));
+    } else {
+      return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_GT_OQ));
+    }
+  }
+# else
+  using real_vector = __m128d;
+  using integer_vector = __m128i;
+
+  static inline real_vector load(const real_type* pointer)
+  {
+    return _mm_loadu_pd(pointer);
+  }
+
+  static inline integer_vector load(const integer_type* pointer)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer));
+  }
+
+  static inline void store(real_type* pointer, real_vector vector)
+  {
+    _mm_storeu_pd(pointer, vector);
+  }
+
+  static inline void store(integer_type* pointer, integer_vector vector)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pointer), vector);
+  }
+
+  static inline real_vector splat(real_type value)
+  {
+    return _mm_set1_pd(value);
+  }
+
+  static inline integer_vector splat(integer_type value)
+  {
+    return _mm_set1_epi64x(value);
+  }
+
+  static inline real_vector add(real_vector a, real_vector b)
+  {
+    return _mm_add_pd(a, b);
+  }
+
+  static inline real_vector subtract(real_vector a, real_vector b)
+  {
+    return _mm_sub_pd(a, b);
+  }
+
+  static inline real_vector multiply(real_vector a, real_vector b)
+  {
+    return _mm_mul_pd(a, b);
+  }
+
+  static inline real_vector divide(real_vector a, real_vector b)
+  {
+    return _mm_div_pd(a, b);
+  }
+
+  static inline real_vector min(real_vector a, real_vector b)
+  {
+    return _mm_min_pd(a, b);
+  }
+
+  static inline real_vector max(real_vector a, real_vector b)
+  {
+    return _mm_max_pd(a, b);
+  }
+
+  static inline integer_vector add(integer_vector a, integer_vector b)
+  {
+    return _mm_add_epi64(a, b);
+  }
+
+  static inline integer_vector subtract(integer_vector a, integer_vector b)
+  {
+    return _mm_sub_epi64(a, b);
+  }
+
+  static inline integer_vector bitwise_and(integer_vector a, integer_vector b)
+  {
+    return _mm_and_si128(a, b);
+  }
+
+  static inline integer_vector bitwise_or(integer_vector a, integer_vector b)
+  {
+    return _mm_or_si128(a, b);
+  }
+
+  static inline integer_vector bitwise_xor(integer_vector a, integer_vector b)
+  {
+    return _mm_xor_si128(a, b);
+  }
+
+  static inline bool any_negative(integer_vector vector)
+  {
+    return _mm_movemask_pd(_mm_castsi128_pd(vector)) != 0;
+  }
+
+  template<comparison op>
+  static inline integer_vector compare(real_vector a, real_vector b)
+  {
+    if constexpr (op == comparison::equal)
+    {
+      return _mm_castpd_si128(_mm_cmpeq_pd(a, b));
+    }
+    else if constexpr (op == comparison::less)
+    {
+      return _mm_castpd_si128(_mm_cmplt_pd(a, b));
+    } else {
+      return _mm_castpd_si128(_mm_cmpgt_pd(a, b));
+    }
+  }
+# endif
+
+  template<class Vector, class T>
+  static inline T reduce(Vector vector, T (*callback)(T, T))
+  {
+    T slots[lanes];
+    T result;
+
+    store(slots, vector);
+    result = slots[0];
+    for (size_type i = 1; i < lanes; ++i)
+    {
+      result = callback(result, slots[i]);
+    }
+
+    return result;
+  }
+
+  // Sum of two integers overflows if its sign differs from the signs of
+  // both operands.
+  static inline integer_vector add_overflows(
+    integer_vector a,
+    integer_vector b,
+    integer_vector result
+  )
+  {
+    return bitwise_and(bitwise_xor(a, result), bitwise_xor(b, result));
+  }
+
+  // Difference overflows if the operands have different signs, and the sign
+  // of the result differs from the sign of the first operand.
+  static inline integer_vector subtract_overflows(
+    integer_vector a,
+    integer_vector b,
+    integer_vector result
+  )
+  {
+    return bitwise_and(bitwise_xor(a, b), bitwise_xor(a, result));
+  }
+#endif
+
+  template<operation op, class T>
+  static inline T compute(T a, T b)
+  {
+    if constexpr (op == operation::add)
+    {
+      return a + b;
+    }
+    else if constexpr (op == operation::subtract)
+    {
+      return a - b;
+    }
+    else if constexpr (op == operation::multiply)
+    {
+      return a * b;
+    } else {
+      return a / b;
+    }
+  }
+
+#if defined(BALI_SIMD_LANES)
+  template<operation op>
+  static inline real_vector compute(real_vector a, real_vector b)
+  {
+    if constexpr (op == operation::add)
+    {
+      return add(a, b);
+    }
+    else if constexpr (op == operation::subtract)
+    {
+      return subtract(a, b);
+    }
+    else if constexpr (op == operation::multiply)
+    {
+      return multiply(a, b);
+    } else {
+      return divide(a, b);
+    }
+  }
+#endif
+
+  template<comparison op, class T>
+  static inline bool compare(T a, T b)
+  {
+    if constexpr (op == comparison::equal)
+    {
+      return a == b;
+    }
+    else if constexpr (op == comparison::less)
+    {
+      return a < b;
+    } else {
+      return a > b;
+    }
+  }
+
+  static inline real_type add_real(real_type a, real_type b)
+  {
+    return a + b;
+  }
+
+  static inline real_type min_real(real_type a, real_type b)
+  {
+    return std::min(a, b);
+  }
+
+  static inline real_type max_real(real_type a, real_type b)
+  {
+    return std::max(a, b);
+  }
+
+  real_type
+  sum(const real_type* data, size_type size)
+  {
+    real_type result = 0;
+    size_type i = 0;
+
+#if defined(BALI_SIMD_LANES)
+    if (size >= lanes)
+    {
+      auto accumulator = load(data);
+
+      for (i = lanes; i + lanes <= size; i += lanes)
+      {
+        accumulator = add(accumulator, load(data + i));
+      }
+      result = reduce(accumulator, add_real);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result += data[i];
+    }
+
+    return result;
+  }
+
+  real_type
+  dot(const real_type* a, const real_type* b, size_type size)
+  {
+    real_type result = 0;
+    size_type i = 0;
+
+#if defined(BALI_SIMD_LANES)
+    if (size >= lanes)
+    {
+      auto accumulator = multiply(load(a), load(b));
+
+      for (i = lanes; i + lanes <= size; i += lanes)
+      {
+        accumulator = add(accumulator, multiply(load(a + i), load(b + i)));
+      }
+      result = reduce(accumulator, add_real);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result += a[i] * b[i];
+    }
+
+    return result;
+  }
+
+  real_type
+  min(const real_type* data, size_type size)
+  {
+    real_type result = data[0];
+    size_type i = 1;
+
+#if defined(BALI_SIMD_LANES)
+    if (size >= lanes)
+    {
+      auto accumulator = load(data);
+
+      for (i = lanes; i + lanes <= size; i += lanes)
+      {
+        accumulator = min(accumulator, load(data + i));
+      }
+      result = reduce(accumulator, min_real);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result = std::min(result, data[i]);
+    }
+
+    return result;
+  }
+
+  real_type
+  max(const real_type* data, size_type size)
+  {
+    real_type result = data[0];
+    size_type i = 1;
+
+#if defined(BALI_SIMD_LANES)
+    if (size >= lanes)
+    {
+      auto accumulator = load(data);
+
+      for (i = lanes; i + lanes <= size; i += lanes)
+      {
+        accumulator = max(accumulator, load(data + i));
+      }
+      result = reduce(accumulator, max_real);
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result = std::max(result, data[i]);
+    }
+
+    return result;
+  }
+
+  bool
+  sum(const integer_type* data, size_type size, integer_type& result)
+  {
+    size_type i = 0;
+
+    result = 0;
+#if defined(BALI_SIMD_LANES)
+    if (size >= lanes)
+    {
+      integer_type slots[lanes];
+      auto accumulator = splat(integer_type(0));
+      auto overflow = splat(integer_type(0));
+
+      for (; i + lanes <= size; i += lanes)
+      {
+        const auto operand = load(data + i);
+        const auto next = add(accumulator, operand);
+
+        overflow = bitwise_or(
+          overflow,
+          add_overflows(accumulator, operand, next)
+        );
+        accumulator = next;
+      }
+      if (any_negative(overflow))
+      {
+        return false;
+      }
+      store(slots, accumulator);
+      for (const auto slot : slots)
+      {
+        if (utils::add_overflows(result, slot))
+        {
+          return false;
+        }
+        result += slot;
+      }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      if (utils::add_overflows(result, data[i]))
+      {
+        return false;
+      }
+      result += data[i];
+    }
+
+    return true;
+  }
+
+  bool
+  dot(
+    const integer_type* a,
+    const integer_type* b,
+    size_type size,
+    integer_type& result
+  )
+  {
+    result = 0;
+    for (size_type i = 0; i < size; ++i)
+    {
+      if (utils::multiply_overflows(a[i], b[i]))
+      {
+        return false;
+      }
+
+      const auto product = a[i] * b[i];
+
+      if (utils::add_overflows(result, product))
+      {
+        return false;
+      }
+      result += product;
+    }
+
+    return true;
+  }
+
+  integer_type
+  min(const integer_type* data, size_type size)
+  {
+    return *std::min_element(data, data + size);
+  }
+
+  integer_type
+  max(const integer_type* data, size_type size)
+  {
+    return *std::max_element(data, data + size);
+  }
+
+  template<operation op>
+  static void
+  apply_real(
+    const real_type* a,
+    const real_type* b,
+    real_type* result,
+    size_type size
+  )
+  {
+    size_type i = 0;
+
+#if defined(BALI_SIMD_LANES)
+    for (; i + lanes <= size; i += lanes)
+    {
+      store(result + i, compute<op>(load(a + i), load(b + i)));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result[i] = compute<op, real_type>(a[i], b[i]);
+    }
+  }
+
+  void
+  apply(
+    operation op,
+    const real_type* a,
+    const real_type* b,
+    real_type* result,
+    size_type size
+  )
+  {
+    switch (op)
+    {
+      case operation::add:
+        apply_real<operation::add>(a, b, result, size);
+        break;
+
+      case operation::subtract:
+        apply_real<operation::subtract>(a, b, result, size);
+        break;
+
+      case operation::multiply:
+        apply_real<operation::multiply>(a, b, result, size);
+        break;
+
+      case operation::divide:
+        apply_real<operation::divide>(a, b, result, size);
+        break;
+    }
+  }
+
+  template<operation op>
+  static bool
+  apply_integer(
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    size_type i = 0;
+
+#if defined(BALI_SIMD_LANES)
+    if constexpr (op == operation::add || op == operation::subtract)
+    {
+      auto overflow = splat(integer_type(0));
+
+      for (; i + lanes <= size; i += lanes)
+      {
+        const auto x = load(a + i);
+        const auto y = load(b + i);
+
+        if constexpr (op == operation::add)
+        {
+          const auto z = add(x, y);
+
+          overflow = bitwise_or(overflow, add_overflows(x, y, z));
+          store(result + i, z);
+        } else {
+          const auto z = subtract(x, y);
+
+          overflow = bitwise_or(overflow, subtract_overflows(x, y, z));
+          store(result + i, z);
+        }
+      }
+      if (any_negative(overflow))
+      {
+        return false;
+      }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      if constexpr (op == operation::add)
+      {
+        if (utils::add_overflows(a[i], b[i]))
+        {
+          return false;
+        }
+      }
+      else if constexpr (op == operation::subtract)
+      {
+        if (utils::subtract_overflows(a[i], b[i]))
+        {
+          return false;
+        }
+      }
+      else if constexpr (op == operation::multiply)
+      {
+        if (utils::multiply_overflows(a[i], b[i]))
+        {
+          return false;
+        }
+      }
+      else if (
+        (a[i] == std::numeric_limits<integer_type>::min() && b[i] == -1) ||
+        a[i] % b[i] != 0
+      )
+      {
+        return false;
+      }
+      result[i] = compute<op, integer_type>(a[i], b[i]);
+    }
+
+    return true;
+  }
+
+  bool
+  apply(
+    operation op,
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    switch (op)
+    {
+      case operation::add:
+        return apply_integer<operation::add>(a, b, result, size);
+
+      case operation::subtract:
+        return apply_integer<operation::subtract>(a, b, result, size);
+
+      case operation::multiply:
+        return apply_integer<operation::multiply>(a, b, result, size);
+
+      case operation::divide:
+        return apply_integer<operation::divide>(a, b, result, size);
+    }
+
+    return false;
+  }
+
+  template<comparison op>
+  static void
+  compare_real(
+    const real_type* a,
+    const real_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    size_type i = 0;
+
+#if defined(BALI_SIMD_LANES)
+    const auto one = splat(integer_type(1));
+
+    for (; i + lanes <= size; i += lanes)
+    {
+      store(
+        result + i,
+        bitwise_and(compare<op>(load(a + i), load(b + i)), one)
+      );
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      result[i] = compare<op, real_type>(a[i], b[i]);
+    }
+  }
+
+  void
+  compare(
+    comparison op,
+    const real_type* a,
+    const real_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    switch (op)
+    {
+      case comparison::equal:
+        compare_real<comparison::equal>(a, b, result, size);
+        break;
+
+      case comparison::less:
+        compare_real<comparison::less>(a, b, result, size);
+        break;
+
+      case comparison::greater:
+        compare_real<comparison::greater>(a, b, result, size);
+        break;
+    }
+  }
+
+  template<comparison op>
+  static void
+  compare_integer(
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    for (size_type i = 0; i < size; ++i)
+    {
+      result[i] = compare<op, integer_type>(a[i], b[i]);
+    }
+  }
+
+  void
+  compare(
+    comparison op,
+    const integer_type* a,
+    const integer_type* b,
+    integer_type* result,
+    size_type size
+  )
+  {
+    switch (op)
+    {
+      case comparison::equal:
+        compare_integer<comparison::equal>(a, b, result, size);
+        break;
+
+      case comparison::less:
+        compare_integer<comparison::less>(a, b, result, size);
+        break;
+
+      case comparison::greater:
+        compare_integer<comparison::greater>(a, b, result, size);
+        break;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#include <unordered_map>
+#include <vector>
+
+#include <bali/symbol.hpp>
+
+namespace bali::symbol
+{
+  namespace
+  {
+    struct table
+    {
+      std::unordered_map<std::u32string, id> ids;
+      std::vector<const std::u32string*> names;
+
+      table()
+      {
+        intern(U"nil");
+        intern(U"true");
+        intern(U"quote");
+        intern(U"let");
+        intern(U"lambda");
+        intern(U"defun");
+        intern(U"dotimes");
+        intern(U"loop");
+      }
+
+      id intern(const std::u32string& name)
+      {
+        const auto result = ids.emplace(name, static_cast<id>(names.size()));
+
+        if (result.second)
+        {
+          names.push_back(&result.first->first);
+        }
+
+        return result.first->second;
+      }
+    };
+  }
+
+  static inline table&
+  get_table()
+  {
+    static table instance;
+
+    return instance;
+  }
+
+  id
+  intern(const std::u32string& name)
+  {
+    return get_table().intern(name);
+  }
+
+  const std::u32string&
+  name(id symbol)
+  {
+    return *get_table().names[symbol];
+  }
+}
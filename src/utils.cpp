@@ -2,6 +2,30 @@
 
 namespace bali::utils
 {
+  static bool
+  is_exponent(const std::u32string& input, std::u32string::size_type start)
+  {
+    const auto length = input.length();
+
+    if (start < length && (input[start] == U'+' || input[start] == U'-'))
+    {
+      ++start;
+    }
+    if (start >= length)
+    {
+      return false;
+    }
+    for (auto i = start; i < length; ++i)
+    {
+      if (!std::isdigit(input[i]))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   bool
   is_number(const std::u32string& input)
   {
@@ -14,7 +38,7 @@ namespace bali::utils
       return false;
     }
 
-    if (input[0] == U'+' || input[1] == U'-')
+    if (input[0] == U'+' || input[0] == U'-')
     {
       start = 1;
       if (length < 2)
@@ -25,6 +49,12 @@ namespace bali::utils
       start = 0;
     }
 
+    // Infinities and NaN, as written by the printer.
+    if (!input.compare(start, 3, U"inf") || !input.compare(start, 3, U"nan"))
+    {
+      return length - start == 3;
+    }
+
     for (std::u32string::size_type i = start; i < length; ++i)
     {
       const auto& c = input[i];
@@ -37,6 +67,10 @@ namespace bali::utils
         }
         dot_seen = true;
       }
+      else if ((c == U'e' || c == U'E') && i > start)
+      {
+        return is_exponent(input, i + 1);
+      }
       else if (!std::isdigit(c))
       {
         return false;
@@ -1,14 +1,16 @@
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 
 #include <peelo/unicode/encoding/utf8.hpp>
 
+#include <bali/bytecode.hpp>
 #include <bali/error.hpp>
 #include <bali/eval.hpp>
-
-#if !defined(BUFSIZ)
-#  define BUFSIZ 1024
-#endif
+#include <bali/printer.hpp>
+#include <bali/resolver.hpp>
+#include <bali/utils.hpp>
 
 namespace bali
 {
@@ -16,57 +18,506 @@ namespace bali
     const std::optional<int>& line,
     const std::optional<int>& column
   )
-    : m_line(line)
-    , m_column(column) {}
+    : m_location(location::make(line, column)) {}
+
+  value::value(location::id location)
+    : m_location(location) {}
+
+  value::~value()
+  {
+    location::release(m_location);
+  }
+
+  // The prototype is never freed, so that it can be used without caring
+  // about the order in which static variables are destroyed.
+  value*
+  value::ptr::prototype()
+  {
+    static const auto instance = new atom(symbol::nil, location::id::none);
+
+    return instance;
+  }
+
+  memory::ref<value::atom>
+  value::ptr::box() const
+  {
+    if (is_integer())
+    {
+      return memory::ref<atom>(
+        new atom(bali::number(integer()), location::id::none)
+      );
+    }
+    else if (is_real())
+    {
+      return memory::ref<atom>(
+        new atom(bali::number(real()), location::id::none)
+      );
+    }
+    else if (is_symbol())
+    {
+      return memory::ref<atom>(new atom(symbol(), location::id::none));
+    }
+
+    return memory::ref<atom>(static_cast<atom*>(get()));
+  }
+
+  bool
+  value::ptr::as_number(bali::number& slot) const
+  {
+    if (is_integer())
+    {
+      slot = integer();
+
+      return true;
+    }
+    else if (is_real())
+    {
+      slot = real();
+
+      return true;
+    }
+    else if (is_symbol())
+    {
+      const auto& name = symbol::name(symbol());
+
+      if (!utils::is_number(name))
+      {
+        return false;
+      }
+      slot = bali::number::parse(name);
+
+      return true;
+    }
+    else if (!m_word || get()->type() != type::atom)
+    {
+      return false;
+    }
+
+    return static_cast<const atom*>(get())->number(slot);
+  }
+
+  std::u32string
+  value::to_string(const ptr& value)
+  {
+    std::stringbuf buffer;
+
+    print(buffer, value);
+
+    return peelo::unicode::encoding::utf8::decode(buffer.str());
+  }
+
+  value::atom::atom(symbol::id id, location::id location)
+    : value::value(location)
+    , m_id(id)
+    , m_number_state(number_state::unknown) {}
+
+  value::atom::atom(
+    symbol::id id,
+    const lexical_address& address,
+    location::id location
+  )
+    : value::value(location)
+    , m_id(id)
+    , m_address(address)
+    , m_number_state(number_state::unknown) {}
+
+  value::atom::atom(const bali::number& number, location::id location)
+    : value::value(location)
+    , m_number_state(number_state::number)
+    , m_number(number) {}
 
-  std::shared_ptr<value::atom>
+  value::ptr
+  value::atom::make_bool(
+    bool value,
+    const std::optional<int>& line,
+    const std::optional<int>& column
+  )
+  {
+    if (!value)
+    {
+      return nullptr;
+    }
+    else if (line || column)
+    {
+      return memory::ref<atom>(
+        new atom(symbol::true_, location::make(line, column))
+      );
+    }
+
+    return ptr::make_symbol(symbol::true_);
+  }
+
+  value::ptr
   value::atom::make_number(
-    double value,
+    const bali::number& value,
     const std::optional<int>& line,
     const std::optional<int>& column
   )
   {
-    using peelo::unicode::encoding::utf8::decode;
-    char buffer[BUFSIZ];
+    if (!line && !column)
+    {
+      if (value.is_integer() && ptr::fits_integer(value.integer()))
+      {
+        return ptr::make_integer(value.integer());
+      }
+      else if (!value.is_exact() && ptr::fits_real(value.real()))
+      {
+        return ptr::make_real(value.real());
+      }
+    }
 
-    std::snprintf(buffer, BUFSIZ, "%g", value);
+    return memory::ref<atom>(new atom(value, location::make(line, column)));
+  }
 
-    return make(decode(buffer), line, column);
+  value::atom::const_reference
+  value::atom::symbol() const
+  {
+    if (m_symbol)
+    {
+      return *m_symbol;
+    }
+    else if (m_id)
+    {
+      return symbol::name(*m_id);
+    }
+    m_symbol = m_number.to_string();
+
+    return *m_symbol;
   }
 
-  value::atom::atom(
-    const std::u32string& symbol,
+  symbol::id
+  value::atom::id() const
+  {
+    if (!m_id)
+    {
+      m_id = symbol::intern(symbol());
+    }
+
+    return *m_id;
+  }
+
+  bool
+  value::atom::number(bali::number& slot) const
+  {
+    if (m_number_state == number_state::unknown)
+    {
+      const auto& text = symbol();
+
+      if (utils::is_number(text))
+      {
+        m_number = bali::number::parse(text);
+        m_number_state = number_state::number;
+      } else {
+        m_number_state = number_state::not_a_number;
+      }
+    }
+    if (m_number_state == number_state::number)
+    {
+      slot = m_number;
+
+      return true;
+    }
+
+    return false;
+  }
+
+  value::list::list(
+    const memory::ref<struct buffer>& buffer,
+    size_type offset,
+    location::id location
+  )
+    : value::value(location)
+    , m_buffer(buffer)
+    , m_offset(offset) {}
+
+  value::list::list(
+    iterator first_begin,
+    iterator first_end,
+    iterator second_begin,
+    iterator second_end,
+    location::id location
+  )
+    : value::value(location)
+    , m_offset((first_end - first_begin) + (second_end - second_begin))
+  {
+    std::copy(
+      second_begin,
+      second_end,
+      std::copy(first_begin, first_end, m_inline)
+    );
+  }
+
+  const memory::ref<value::list>&
+  value::list::make_empty()
+  {
+    static const auto constant = new memory::ref<list>(new list(
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      location::id::none
+    ));
+
+    return *constant;
+  }
+
+  memory::ref<value::list>
+  value::list::allocate(container_type&& elements, location::id location)
+  {
+    const auto size = elements.size();
+
+    if (size <= inline_capacity)
+    {
+      return memory::ref<list>(new list(
+        elements.data(),
+        elements.data() + size,
+        nullptr,
+        nullptr,
+        location
+      ));
+    }
+
+    return memory::ref<list>(new list(
+      memory::make<buffer>(std::move(elements)),
+      0,
+      location
+    ));
+  }
+
+  memory::ref<value::list>
+  value::list::rest() const
+  {
+    if (size() == 1)
+    {
+      return make_empty();
+    }
+    else if (!m_buffer)
+    {
+      return memory::ref<list>(new list(
+        m_inline + 1,
+        m_inline + m_offset,
+        nullptr,
+        nullptr,
+        location::id::none
+      ));
+    }
+
+    return memory::ref<list>(new list(
+      m_buffer,
+      m_offset + 1,
+      location::id::none
+    ));
+  }
+
+  memory::ref<value::list>
+  value::list::prepend(iterator begin, iterator end) const
+  {
+    const auto count = static_cast<size_type>(end - begin);
+    auto buffer = m_buffer;
+    auto offset = m_offset;
+
+    if (!buffer && offset + count <= inline_capacity)
+    {
+      return memory::ref<list>(new list(
+        begin,
+        end,
+        m_inline,
+        m_inline + offset,
+        location::id::none
+      ));
+    }
+
+    // Slots in front of this list can be used only if no other list has
+    // already claimed them. Otherwise the elements are copied into a new
+    // buffer that has room to grow.
+    if (!buffer || offset != buffer->first || offset < count)
+    {
+      const auto elements = this->elements();
+      const auto size = elements.size();
+      const auto capacity = std::max<size_type>((size + count) * 2, 8);
+
+      buffer = memory::make<struct buffer>();
+      buffer->elements.resize(capacity);
+      offset = capacity - size;
+      std::copy(
+        std::begin(elements),
+        std::end(elements),
+        std::begin(buffer->elements) + offset
+      );
+    }
+    offset -= count;
+    std::copy(begin, end, std::begin(buffer->elements) + offset);
+    buffer->first = offset;
+
+    return memory::ref<list>(new list(
+      buffer,
+      offset,
+      location::id::none
+    ));
+  }
+
+  value::array::array(
+    integer_container_type&& integers,
+    real_container_type&& reals,
+    bool is_integer,
     const std::optional<int>& line,
     const std::optional<int>& column
   )
     : value::value(line, column)
-    , m_symbol(symbol) {}
+    , m_integers(std::move(integers))
+    , m_reals(std::move(reals))
+    , m_is_integer(is_integer) {}
 
-  value::list::list(
-    const container_type& elements,
+  memory::ref<value::array>
+  value::array::slice(size_type begin, size_type end) const
+  {
+    if (m_is_integer)
+    {
+      return make(integer_container_type(
+        std::begin(m_integers) + begin,
+        std::begin(m_integers) + end
+      ));
+    }
+
+    return make(real_container_type(
+      std::begin(m_reals) + begin,
+      std::begin(m_reals) + end
+    ));
+  }
+
+  value::vector::vector(
+    const memory::ref<node>& root,
+    unsigned shift,
+    size_type offset,
+    size_type size,
     const std::optional<int>& line,
     const std::optional<int>& column
   )
     : value::value(line, column)
-    , m_elements(elements) {}
+    , m_root(root)
+    , m_shift(shift)
+    , m_offset(offset)
+    , m_size(size) {}
 
-  std::u32string
-  value::list::to_string() const
+  // Builds the tree from the bottom up, by first filling the leaves and then
+  // the levels of branches above them until only the root remains.
+  memory::ref<value::vector>
+  value::vector::make(
+    iterator begin,
+    iterator end,
+    const std::optional<int>& line,
+    const std::optional<int>& column
+  )
   {
-    const auto size = m_elements.size();
-    std::u32string result(1, U'(');
+    const auto size = static_cast<size_type>(end - begin);
+    std::vector<memory::ref<node>> level;
+    unsigned shift = 0;
 
-    for (value::list::container_type::size_type i = 0; i < size; ++i)
+    for (size_type i = 0; i < size; i += width)
     {
-      if (i > 0)
+      const auto node = memory::make<leaf>();
+
+      std::copy(begin + i, begin + std::min(i + width, size), node->values);
+      level.push_back(node);
+    }
+    while (level.size() > 1)
+    {
+      std::vector<memory::ref<node>> parents;
+
+      for (size_type i = 0; i < level.size(); i += width)
       {
-        result += U' ';
+        const auto node = memory::make<branch>();
+
+        std::copy(
+          std::begin(level) + i,
+          std::begin(level) + std::min(i + width, level.size()),
+          node->children
+        );
+        parents.push_back(node);
       }
-      result += value::to_string(m_elements[i]);
+      level = std::move(parents);
+      shift += bits;
+    }
+
+    return memory::ref<vector>(new vector(
+      level.empty() ? nullptr : level[0],
+      shift,
+      0,
+      size,
+      line,
+      column
+    ));
+  }
+
+  const value::vector::value_type&
+  value::vector::at(size_type index) const
+  {
+    const auto position = m_offset + index;
+    auto current = m_root.get();
+
+    for (auto shift = m_shift; shift > 0; shift -= bits)
+    {
+      current = static_cast<const branch*>(current)->children[
+        (position >> shift) & mask
+      ].get();
     }
-    result += U')';
 
-    return result;
+    return static_cast<const leaf*>(current)->values[position & mask];
+  }
+
+  memory::ref<value::vector::node>
+  value::vector::set(
+    const memory::ref<node>& node,
+    unsigned shift,
+    size_type index,
+    const value_type& value
+  )
+  {
+    if (!shift)
+    {
+      const auto copy = memory::make<leaf>(
+        *memory::static_pointer_cast<leaf>(node)
+      );
+
+      copy->values[index & mask] = value;
+
+      return copy;
+    }
+
+    const auto copy = memory::make<branch>(
+      *memory::static_pointer_cast<branch>(node)
+    );
+    auto& child = copy->children[(index >> shift) & mask];
+
+    child = set(child, shift - bits, index, value);
+
+    return copy;
+  }
+
+  memory::ref<value::vector>
+  value::vector::set(size_type index, const value_type& value) const
+  {
+    return memory::ref<vector>(new vector(
+      set(m_root, m_shift, m_offset + index, value),
+      m_shift,
+      m_offset,
+      m_size,
+      std::nullopt,
+      std::nullopt
+    ));
+  }
+
+  memory::ref<value::vector>
+  value::vector::slice(size_type begin, size_type end) const
+  {
+    return memory::ref<vector>(new vector(
+      m_root,
+      m_shift,
+      m_offset + begin,
+      end - begin,
+      std::nullopt,
+      std::nullopt
+    ));
   }
 
   value::function::function(
@@ -86,24 +537,29 @@ namespace bali
 
   value::ptr
   value::function::builtin::call(
-    const value::list::container_type& arguments,
-    const std::shared_ptr<class scope>& scope
+    const value::list::iterator& begin,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope
   ) const
   {
-    auto begin = std::begin(arguments);
-    const auto end = std::end(arguments);
-
-    return m_callback(begin, end, scope);
+    return call(begin, end, scope, nullptr);
   }
 
-  std::u32string
-  value::function::builtin::to_string() const
+  value::ptr
+  value::function::builtin::call(
+    const value::list::iterator& begin,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    tail_expression* tail
+  ) const
   {
-    return U"<builtin function: " + *name() + U">";
+    auto it = begin;
+
+    return m_callback(it, end, scope, tail);
   }
 
   value::function::custom::custom(
-    const std::vector<std::u32string>& parameters,
+    const std::vector<symbol::id>& parameters,
     const ptr& expression,
     const std::optional<std::u32string>& name,
     const std::optional<int>& line,
@@ -111,7 +567,7 @@ namespace bali
   )
     : value::function::function(name, line, column)
     , m_parameters(parameters)
-    , m_expression(expression) {}
+    , m_expression(resolve(parameters, expression)) {}
 
   static inline std::u32string
   get_function_name(const std::optional<std::u32string>& name)
@@ -119,17 +575,19 @@ namespace bali
     return name ? *name : U"<anonymous>";
   }
 
-  value::ptr
-  value::function::custom::call(
-    const value::list::container_type& arguments,
-    const std::shared_ptr<class scope>& scope
+  memory::ref<scope>
+  value::function::custom::bind(
+    const value::list::iterator& begin,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope,
+    const memory::ref<class scope>& evaluation_scope
   ) const
   {
-    const auto size = arguments.size();
+    const auto size = static_cast<value::list::size_type>(end - begin);
     const auto function_scope =
       m_parameters.empty()
         ? scope
-        : std::make_shared<class scope>(scope);
+        : memory::make<class scope>(scope, m_parameters.size());
 
     if (size < m_parameters.size())
     {
@@ -139,52 +597,90 @@ namespace bali
     {
       throw error(get_function_name(name()) + U": Too many arguments.");
     }
-    for (value::list::size_type i = 0; i < size; ++i)
+    for (value::list::size_type i = 0; i < size && !is_returning(); ++i)
     {
-      function_scope->let(m_parameters[i], arguments[i]);
+      function_scope->let(
+        m_parameters[i],
+        evaluation_scope ? eval(begin[i], evaluation_scope) : begin[i]
+      );
     }
 
-    try
-    {
-      return eval(m_expression, function_scope);
-    }
-    catch (function_return& e)
+    return function_scope;
+  }
+
+  value::ptr
+  value::function::custom::call(
+    const value::list::iterator& begin,
+    const value::list::iterator& end,
+    const memory::ref<class scope>& scope
+  ) const
+  {
+    if (is_returning())
     {
-      return e.value();
+      return nullptr;
     }
+
+    return execute(bind(begin, end, scope), scope);
   }
 
-  std::u32string
-  value::function::custom::to_string() const
+  value::ptr
+  value::function::custom::execute(
+    const memory::ref<class scope>& function_scope,
+    const memory::ref<class scope>& scope
+  ) const
   {
-    std::u32string result(1, U'(');
-    const auto parameters_size = m_parameters.size();
+    value::ptr result;
 
-    if (const auto n = name())
+    if (is_returning())
     {
-      result += U"defun " + *n + U' ';
-    } else {
-      result += U"lambda ";
+      return nullptr;
     }
-    result += '(';
-    for (std::vector<std::string>::size_type i = 0; i < parameters_size; ++i)
+    else if (bytecode::enabled)
     {
-      if (i > 0)
+      bytecode::tail_call tail;
+
+      result = compile().execute(function_scope, &tail);
+
+      // Scopes of functions called in tail position are created on top of
+      // the scope of the calling function, dropping the scopes that they
+      // shadow, so that tail recursion runs in constant space.
+      while (tail.function)
       {
-        result += U' ';
+        const auto function = std::move(tail.function);
+        const auto tail_scope = function->bind(
+          tail.arguments.data(),
+          tail.arguments.data() + tail.arguments.size(),
+          tail.scope
+        );
+
+        tail_scope->drop_shadowed(scope);
+        result = function->compile().execute(tail_scope, &tail);
       }
-      result += m_parameters[i];
+    } else {
+      result = eval(m_expression, function_scope);
+    }
+
+    return is_returning() ? end_return() : result;
+  }
+
+  const bytecode::program&
+  value::function::custom::compile() const
+  {
+    if (!m_program)
+    {
+      m_program = std::make_shared<bytecode::program>(m_expression);
     }
 
-    return result + U") " + value::to_string(m_expression) + U')';
+    return *m_program;
   }
 
   std::ostream&
   operator<<(std::ostream& os, const value::ptr& value)
   {
-    using peelo::unicode::encoding::utf8::encode;
-
-    os << encode(value::to_string(value));
+    if (const auto buffer = os.rdbuf())
+    {
+      print(*buffer, value);
+    }
 
     return os;
   }
@@ -0,0 +1,399 @@
+#include <iterator>
+
+#include <bali/bytecode.hpp>
+#include <bali/error.hpp>
+#include <bali/eval.hpp>
+
+namespace bali::bytecode
+{
+  using stack_type = std::vector<value::ptr>;
+  using number_stack_type = std::vector<number>;
+
+  static inline const value::ptr&
+  get_argument(const value::ptr& form, std::size_t index)
+  {
+    return memory::static_pointer_cast<value::list>(form)->elements()[index];
+  }
+
+  // Converts value into a number. Errors are reported with the position of
+  // the expression that produced the value.
+  static inline number
+  to_number(const value::ptr& value, const value::ptr& form, std::size_t index)
+  {
+    number result;
+
+    if (value.as_number(result))
+    {
+      return result;
+    }
+
+    const auto& expression = get_argument(form, index);
+
+    throw error(
+      U"Value is not a number.",
+      expression ? expression->line() : std::nullopt,
+      expression ? expression->column() : std::nullopt
+    );
+  }
+
+  static void
+  arithmetic(opcode op, number_stack_type& numbers, std::size_t count)
+  {
+    const auto offset = numbers.size() - count;
+    number result;
+
+    switch (op)
+    {
+      case opcode::add:
+        result = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+          result += numbers[offset + i];
+        }
+        break;
+
+      case opcode::multiply:
+        result = 1;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+          result *= numbers[offset + i];
+        }
+        break;
+
+      case opcode::subtract:
+        result = numbers[offset];
+        if (count == 1)
+        {
+          result = -result;
+        }
+        for (std::size_t i = 1; i < count; ++i)
+        {
+          result -= numbers[offset + i];
+        }
+        break;
+
+      default:
+        result = numbers[offset];
+        for (std::size_t i = 1; i < count; ++i)
+        {
+          const auto divider = numbers[offset + i];
+
+          if (divider.is_zero())
+          {
+            throw error(U"/: Division by zero.");
+          }
+          result /= divider;
+        }
+        break;
+    }
+    numbers.resize(offset);
+    numbers.push_back(result);
+  }
+
+  static bool
+  compare(opcode op, const number& left, const number& right)
+  {
+    switch (op)
+    {
+      case opcode::eq:
+        return left == right;
+
+      case opcode::lt:
+        return left < right;
+
+      case opcode::gt:
+        return left > right;
+
+      case opcode::lte:
+        return left <= right;
+
+      default:
+        return left >= right;
+    }
+  }
+
+  // Number stack is shared by all programs, as numbers never stay in it
+  // across calls. Each execution restores the stack to the depth where it
+  // started, no matter how it ends.
+  class number_stack_guard
+  {
+  public:
+    explicit number_stack_guard(number_stack_type& numbers)
+      : m_numbers(numbers)
+      , m_size(numbers.size()) {}
+
+    ~number_stack_guard()
+    {
+      m_numbers.resize(m_size);
+    }
+
+  private:
+    number_stack_type& m_numbers;
+    const number_stack_type::size_type m_size;
+  };
+
+  static value::ptr
+  call_builtin(
+    const memory::ref<value::function>& function,
+    const value::ptr& form,
+    const memory::ref<class scope>& scope
+  )
+  {
+    const auto& elements = memory::static_pointer_cast<value::list>(
+      form
+    )->elements();
+
+    return function->call(
+      elements.data() + 1,
+      elements.data() + elements.size(),
+      scope
+    );
+  }
+
+  value::ptr
+  program::execute(
+    const memory::ref<class scope>& scope,
+    tail_call* tail
+  ) const
+  {
+    const auto size = m_code.size();
+    std::size_t ip = 0;
+    auto current = scope;
+    stack_type stack;
+    static number_stack_type numbers;
+    number_stack_guard guard(numbers);
+
+    while (ip < size)
+    {
+      const auto op = static_cast<opcode>(m_code[ip++]);
+
+      switch (op)
+      {
+        case opcode::push_constant:
+          stack.push_back(m_constants[m_code[ip++]]);
+          break;
+
+        case opcode::push_nil:
+          stack.push_back(nullptr);
+          break;
+
+        case opcode::pop:
+          stack.pop_back();
+          break;
+
+        case opcode::load_local:
+          stack.push_back(current->at({ m_code[ip], m_code[ip + 1] }));
+          ip += 2;
+          break;
+
+        case opcode::eval:
+          stack.push_back(bali::eval(m_constants[m_code[ip++]], current));
+          if (is_returning())
+          {
+            return nullptr;
+          }
+          break;
+
+        case opcode::set_dynamic:
+          current->set(m_code[ip++], stack.back());
+          break;
+
+        case opcode::jump:
+          ip = m_code[ip];
+          break;
+
+        case opcode::jump_if_false:
+        case opcode::jump_if_true:
+          {
+            const auto condition = to_bool(stack.back(), nullptr);
+
+            stack.pop_back();
+            if (condition == (op == opcode::jump_if_true))
+            {
+              ip = m_code[ip];
+            } else {
+              ++ip;
+            }
+          }
+          break;
+
+        case opcode::not_:
+          stack.back() = value::atom::make_bool(
+            !to_bool(stack.back(), nullptr)
+          );
+          break;
+
+        case opcode::push_number:
+          numbers.push_back(m_numbers[m_code[ip++]]);
+          break;
+
+        case opcode::pop_number:
+          numbers.pop_back();
+          break;
+
+        case opcode::unbox:
+          numbers.push_back(to_number(
+            stack.back(),
+            m_constants[m_code[ip]],
+            m_code[ip + 1]
+          ));
+          stack.pop_back();
+          ip += 2;
+          break;
+
+        case opcode::box:
+          stack.push_back(value::atom::make_number(numbers.back()));
+          numbers.pop_back();
+          break;
+
+        case opcode::add:
+        case opcode::subtract:
+        case opcode::multiply:
+        case opcode::divide:
+          arithmetic(op, numbers, m_code[ip++]);
+          break;
+
+        case opcode::eq:
+        case opcode::lt:
+        case opcode::gt:
+        case opcode::lte:
+        case opcode::gte:
+          {
+            const auto right = numbers.back();
+
+            numbers.pop_back();
+            if (compare(op, numbers.back(), right))
+            {
+              ++ip;
+            } else {
+              ip = m_code[ip];
+            }
+          }
+          break;
+
+        case opcode::call_builtin:
+          {
+            const auto& form = m_constants[m_code[ip]];
+            const auto& callee = stack.back();
+
+            if (!callee || callee->type() != value::type::function)
+            {
+              const auto& head = get_argument(form, 0);
+
+              throw error(
+                U"Value is not a function.",
+                head ? head->line() : std::nullopt,
+                head ? head->column() : std::nullopt
+              );
+            }
+            else if (memory::dynamic_pointer_cast<value::function::builtin>(
+              callee
+            ))
+            {
+              const auto function = memory::static_pointer_cast<
+                value::function
+              >(callee);
+
+              stack.pop_back();
+              stack.push_back(call_builtin(function, form, current));
+              if (is_returning())
+              {
+                return nullptr;
+              }
+              ip += m_code[ip + 1] + 2;
+            } else {
+              ip += 2;
+            }
+          }
+          break;
+
+        case opcode::call:
+        case opcode::tail_call:
+          {
+            const auto count = m_code[ip++];
+            const auto offset = stack.size() - count;
+            const auto function = memory::static_pointer_cast<value::function>(
+              stack[offset - 1]
+            );
+            if (op == opcode::tail_call && tail)
+            {
+              tail->function = memory::static_pointer_cast<
+                value::function::custom
+              >(function);
+              tail->arguments.assign(
+                std::make_move_iterator(std::begin(stack) + offset),
+                std::make_move_iterator(std::end(stack))
+              );
+              tail->scope = current;
+
+              return nullptr;
+            }
+            auto result = function->call(
+              stack.data() + offset,
+              stack.data() + stack.size(),
+              current
+            );
+            stack.resize(offset - 1);
+            stack.push_back(std::move(result));
+            if (is_returning())
+            {
+              return nullptr;
+            }
+          }
+          break;
+
+        case opcode::enter_scope:
+          {
+            const auto& layout = m_layouts[m_code[ip++]];
+            const auto count = layout.size();
+            const auto offset = stack.size() - count;
+            auto new_scope = memory::make<class scope>(current, count);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+              new_scope->let(layout[i], stack[offset + i]);
+            }
+            stack.resize(offset);
+            current = new_scope;
+          }
+          break;
+
+        case opcode::leave_scope:
+          current = current->parent();
+          break;
+
+        case opcode::rebind:
+          {
+            const auto& layout = m_layouts[m_code[ip++]];
+            const auto count = layout.size();
+            const auto offset = stack.size() - count;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+              current->let(layout[i], stack[offset + i]);
+            }
+            stack.resize(offset);
+          }
+          break;
+
+        case opcode::iterate:
+          {
+            auto& counter = numbers.back();
+
+            if (counter < numbers[numbers.size() - 2])
+            {
+              current->let(m_code[ip + 1], value::atom::make_number(counter));
+              counter += 1;
+              ip += 2;
+            } else {
+              numbers.resize(numbers.size() - 2);
+              ip = m_code[ip];
+            }
+          }
+          break;
+      }
+    }
+
+    return stack.empty() ? nullptr : stack.back();
+  }
+}